@@ -0,0 +1,164 @@
+// MIT License
+
+// Author : Codinablack@github.com
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <span>
+#include "pointbasedstat.hpp"
+
+// Absorb layers sitting in front of a stat: temporary shields, barrier hp, a mana shield
+// that drains another stat... One damage call walks the layers in priority order,
+// each soaks up its share of what's left, and whatever gets through hits the stat.
+template<PositiveNumber NumberType, class Policy = OverflowPolicy::Clamp>
+class AbsorbChain {
+public:
+
+    struct Absorbed 
+    {
+        uint32_t id;
+        NumberType amount;
+    };
+
+    struct DamageResult 
+    {
+        NumberType absorbed = 0;    // by all layers together
+        NumberType taken = 0;       // removed from the stat
+        NumberType overkill = 0;    // what was left once the stat hit 0
+    };
+
+    // A layer that holds its own points, ratio is how much of the incoming damage
+    // it tries to take in basis points. Lower priorities are hit first.
+    // Without keep_when_empty the layer is dropped once it's used up, like a bubble.
+    // Adding an id that's already here replaces it.
+    void addLayer(uint32_t id, NumberType amount, uint8_t priority = 0, uint16_t ratio = StatMath::BasisPointsOne, bool keep_when_empty = false) 
+    {
+        insert(Layer{id, amount, nullptr, ratio, priority, keep_when_empty});
+    }
+
+    // A layer that drains another stat, e.g. a mana shield taking half of every hit from mana.
+    // It stays until removed even if the backing stat runs dry.
+    void addLayer(uint32_t id, PointStat<NumberType, Policy>& backing, uint8_t priority = 0, uint16_t ratio = StatMath::BasisPointsOne) 
+    {
+        insert(Layer{id, 0, &backing, ratio, priority, true});
+    }
+
+    bool removeLayer(uint32_t id) 
+    {
+        for (std::size_t i = 0; i < layers_.size(); ++i) {
+            if (layers_[i].id == id) {
+                layers_.erase(i);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Points left in a layer, 0 if it's gone
+    NumberType layer(uint32_t id) 
+    {
+        for (auto& entry : layers_) {
+            if (entry.id == id) {
+                return entry.backing ? entry.backing->current() : entry.points;
+            }
+        }
+        return 0;
+    }
+
+    std::size_t size() const 
+    {
+        return layers_.size();
+    }
+
+    // Sends amount through the layers and into stat.
+    // What each layer soaked up is in absorbed() until the next call.
+    DamageResult damage(PointStat<NumberType, Policy>& stat, NumberType amount) 
+    {
+        DamageResult result;
+        absorbed_.clear();
+        NumberType remaining = amount;
+        std::size_t kept = 0;
+        for (std::size_t i = 0; i < layers_.size(); ++i) {
+            Layer entry = layers_[i];
+            if (remaining > 0) {
+                NumberType share = entry.ratio >= StatMath::BasisPointsOne ? remaining 
+                    : static_cast<NumberType>(StatMath::multiplyDivide(remaining, entry.ratio, StatMath::BasisPointsOne));
+                NumberType pool = entry.backing ? entry.backing->current() : entry.points;
+                NumberType take = std::min(share, pool);
+                if (take > 0) {
+                    if (entry.backing) {
+                        entry.backing->remove(take);
+                    }
+                    else {
+                        entry.points -= take;
+                    }
+                    remaining -= take;
+                    result.absorbed += take;
+                    absorbed_.push_back(Absorbed{entry.id, take});
+                }
+            }
+            // Compact as we go so spent layers drop out in the same pass
+            if (entry.keep_when_empty or entry.points > 0) {
+                layers_[kept++] = entry;
+            }
+        }
+        layers_.truncate(kept);
+
+        if (remaining > 0) {
+            NumberType current = stat.current();
+            result.taken = std::min(remaining, current);
+            result.overkill = remaining - result.taken;
+            stat.remove(remaining);
+        }
+        return result;
+    }
+
+    std::span<const Absorbed> absorbed() const 
+    {
+        return {absorbed_.data(), absorbed_.size()};
+    }
+
+private:
+
+    struct Layer 
+    {
+        uint32_t id;
+        NumberType points;
+        PointStat<NumberType, Policy>* backing;
+        uint16_t ratio;
+        uint8_t priority;
+        bool keep_when_empty;
+    };
+
+    void insert(const Layer& layer) 
+    {
+        removeLayer(layer.id);
+        layers_.push_back(layer);
+        // Insertion sort from the back keeps equal priorities in the order they were added
+        for (std::size_t i = layers_.size() - 1; i > 0 and layers_[i - 1].priority > layers_[i].priority; --i) {
+            std::swap(layers_[i - 1], layers_[i]);
+        }
+    }
+
+    SmallVector<Layer, 4> layers_;
+    SmallVector<Absorbed, 4> absorbed_;
+};
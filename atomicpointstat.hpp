@@ -0,0 +1,207 @@
+// MIT License
+
+// Author : Codinablack@github.com
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <stdexcept>
+#include "pointbasedstat.hpp"
+
+// A PointStat for the handful of entities every thread hits at once (raid bosses and the like).
+// add/remove are CAS loops, so hits from any number of threads land without a lock. There are
+// no modifiers or regen here, whoever owns the entity works out max and pushes it with setMax.
+// 16 and 32 bit stats keep current and max together in one 64 bit word, so every update sees
+// a matching pair. 64 bit stats can't, so they re-check max after every raise of current and
+// pull current back down if a lower max landed in between.
+template<PositiveNumber NumberType>
+class AtomicPointStat {
+public:
+
+    static_assert(std::atomic<NumberType>::is_always_lock_free, "AtomicPointStat needs a lock free NumberType");
+
+    static constexpr bool Packed = sizeof(NumberType) <= 4 and std::atomic<uint64_t>::is_always_lock_free;
+
+    AtomicPointStat(NumberType initial, NumberType max)
+    {
+        if (max <= 0) 
+        {
+            throw std::invalid_argument("PointStat max must be positive");
+        }
+        if constexpr (Packed) {
+            state_.word.store(pack(std::min(initial, max), max), std::memory_order_relaxed);
+        }
+        else {
+            state_.current.store(std::min(initial, max), std::memory_order_relaxed);
+            state_.max.store(max, std::memory_order_relaxed);
+        }
+    }
+
+    AtomicPointStat(const AtomicPointStat&) = delete;
+    AtomicPointStat& operator=(const AtomicPointStat&) = delete;
+
+    NumberType current() const 
+    {
+        if constexpr (Packed) {
+            return currentOf(state_.word.load(std::memory_order_acquire));
+        }
+        else {
+            return state_.current.load(std::memory_order_acquire);
+        }
+    }
+
+    NumberType max() const 
+    {
+        if constexpr (Packed) {
+            return maxOf(state_.word.load(std::memory_order_acquire));
+        }
+        else {
+            return state_.max.load(std::memory_order_acquire);
+        }
+    }
+
+    // Same as PointStat::add, false if it had to stop at max
+    bool add(NumberType points) 
+    {
+        if constexpr (Packed) {
+            uint64_t word = state_.word.load(std::memory_order_relaxed);
+            for (;;) {
+                const NumberType current = currentOf(word);
+                const NumberType max = maxOf(word);
+                const bool fits = points <= static_cast<NumberType>(max - current);
+                const NumberType next = fits ? static_cast<NumberType>(current + points) : max;
+                if (state_.word.compare_exchange_weak(word, pack(next, max), std::memory_order_acq_rel, std::memory_order_relaxed)) {
+                    return fits;
+                }
+            }
+        }
+        else {
+            NumberType current = state_.current.load(std::memory_order_relaxed);
+            for (;;) {
+                const NumberType max = state_.max.load();
+                const bool fits = current <= max and points <= static_cast<NumberType>(max - current);
+                const NumberType next = fits ? static_cast<NumberType>(current + points) : max;
+                // seq_cst here and in setMax, so at least one of the two sees the other's store
+                if (state_.current.compare_exchange_weak(current, next, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                    clampToMax(next);
+                    return fits;
+                }
+            }
+        }
+    }
+
+    // Same as PointStat::remove, false if it had to stop at 0
+    bool remove(NumberType points) 
+    {
+        bool crossed_zero;
+        return remove(points, crossed_zero);
+    }
+
+    // crossed_zero is set for exactly one caller per trip to 0, the one whose hit took
+    // the last point, so death handling can hang off it without any further locking.
+    // A heal and another kill later signals again.
+    bool remove(NumberType points, bool& crossed_zero) 
+    {
+        if constexpr (Packed) {
+            uint64_t word = state_.word.load(std::memory_order_relaxed);
+            for (;;) {
+                const NumberType current = currentOf(word);
+                const bool fits = points <= current;
+                const NumberType next = fits ? static_cast<NumberType>(current - points) : NumberType{0};
+                if (state_.word.compare_exchange_weak(word, pack(next, maxOf(word)), std::memory_order_acq_rel, std::memory_order_relaxed)) {
+                    crossed_zero = current != 0 and next == 0;
+                    return fits;
+                }
+            }
+        }
+        else {
+            NumberType current = state_.current.load(std::memory_order_relaxed);
+            for (;;) {
+                const bool fits = points <= current;
+                const NumberType next = fits ? static_cast<NumberType>(current - points) : NumberType{0};
+                if (state_.current.compare_exchange_weak(current, next, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+                    crossed_zero = current != 0 and next == 0;
+                    return fits;
+                }
+            }
+        }
+    }
+
+    // Lowering max pulls current down with it, raising it leaves current alone
+    void setMax(NumberType max) 
+    {
+        max = std::max<NumberType>(max, 1);
+        if constexpr (Packed) {
+            uint64_t word = state_.word.load(std::memory_order_relaxed);
+            while (not state_.word.compare_exchange_weak(word, pack(std::min(currentOf(word), max), max), 
+                std::memory_order_acq_rel, std::memory_order_relaxed)) {
+            }
+        }
+        else {
+            state_.max.store(max);
+            clampToMax(state_.current.load());
+        }
+    }
+
+private:
+
+    static uint64_t pack(NumberType current, NumberType max) 
+    {
+        return static_cast<uint64_t>(max) << 32 | current;
+    }
+
+    static NumberType currentOf(uint64_t word) 
+    {
+        return static_cast<NumberType>(word & 0xFFFFFFFFu);
+    }
+
+    static NumberType maxOf(uint64_t word) 
+    {
+        return static_cast<NumberType>(word >> 32);
+    }
+
+    // current was just seen as value, bring it back under whatever max is by now
+    void clampToMax(NumberType value) 
+    {
+        NumberType max = state_.max.load();
+        while (value > max) {
+            if (state_.current.compare_exchange_weak(value, max, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                return;
+            }
+            max = state_.max.load();
+        }
+    }
+
+    struct PackedState 
+    {
+        alignas(64) std::atomic<uint64_t> word;
+    };
+
+    // Own cache lines, the whole point is that these get hammered
+    struct SplitState 
+    {
+        alignas(64) std::atomic<NumberType> current;
+        alignas(64) std::atomic<NumberType> max;
+    };
+
+    std::conditional_t<Packed, PackedState, SplitState> state_;
+};
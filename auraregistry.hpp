@@ -0,0 +1,194 @@
+// MIT License
+
+// Author : Codinablack@github.com
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <vector>
+#include "pointbasedstat.hpp"
+
+// Auras, zone effects, guild buffs... one modifier source applied to a lot of stats.
+// Every instance is remembered next to its aura, so applying or dropping an aura only
+// touches the stats that actually have it instead of searching every entity's modifiers.
+// Each aura's modifier carries a source id (one is picked from the top of the range if the
+// modifier has none), so reapplying to a stat that already has it just refreshes.
+// The modifier is kept by value in the aura and handed to each stat by value, auras come and
+// go all the time so they never go through ModifierDefs, which keeps what it's given for good.
+// Like the timer wheel this keeps raw pointers, call forget before a stat goes away.
+template<PositiveNumber NumberType, class Policy = OverflowPolicy::Clamp>
+class AuraRegistry {
+public:
+
+    // Slot in the low half, the slot's generation in the high half,
+    // so an id kept past destroy doesn't reach whatever aura reuses the slot
+    using AuraId = uint64_t;
+
+    // Sources at or above this are handed out to auras created without one
+    static constexpr uint32_t AuraSourceBase = 0xF0000000u;
+
+    AuraId create(Modifier<NumberType> modifier) 
+    {
+        uint32_t index;
+        if (not free_.empty()) {
+            index = free_.back();
+            free_.pop_back();
+        }
+        else {
+            index = static_cast<uint32_t>(auras_.size());
+            auras_.emplace_back();
+        }
+        if (modifier.getSource() == 0) {
+            modifier.setSource(AuraSourceBase + index, StackPolicy::Refresh);
+        }
+        auto& entry = auras_[index];
+        entry.modifier = modifier;
+        entry.alive = true;
+        return (static_cast<AuraId>(entry.generation) << 32) | index;
+    }
+
+    // Returns true if the stat took the modifier (or already had it),
+    // false for an id that was never created or has been destroyed
+    bool apply(AuraId aura, PointStat<NumberType, Policy>& stat) 
+    {
+        if (not valid(aura)) {
+            return false;
+        }
+        auto& entry = auras_[static_cast<uint32_t>(aura)];
+        StackOutcome outcome;
+        ModifierHandle handle = stat.addModifier(entry.modifier, outcome);
+        if (outcome == StackOutcome::Added) {
+            entry.instances.push_back(Instance{&stat, handle});
+        }
+        return static_cast<bool>(handle);
+    }
+
+    // The whole fan out, stats are visited in address order so neighbours in memory go together
+    std::size_t apply(AuraId aura, std::span<PointStat<NumberType, Policy>* const> stats) 
+    {
+        if (not valid(aura)) {
+            return 0;
+        }
+        scratch_.assign(stats.begin(), stats.end());
+        std::sort(scratch_.begin(), scratch_.end(), std::less<PointStat<NumberType, Policy>*>{});
+        std::size_t applied = 0;
+        for (auto* stat : scratch_) {
+            applied += apply(aura, *stat);
+        }
+        return applied;
+    }
+
+    // One stat leaving the aura, O(stats with the aura)
+    bool remove(AuraId aura, PointStat<NumberType, Policy>& stat) 
+    {
+        if (not valid(aura)) {
+            return false;
+        }
+        auto& instances = auras_[static_cast<uint32_t>(aura)].instances;
+        for (std::size_t i = 0; i < instances.size(); ++i) {
+            if (instances[i].stat == &stat) {
+                stat.removeModifier(instances[i].handle);
+                instances[i] = instances.back();
+                instances.pop_back();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Takes the aura off every stat it's on and frees the id, returns how many stats that was
+    std::size_t destroy(AuraId aura) 
+    {
+        if (not valid(aura)) {
+            return 0;
+        }
+        auto& entry = auras_[static_cast<uint32_t>(aura)];
+        std::sort(entry.instances.begin(), entry.instances.end(), [](const Instance& a, const Instance& b) {
+            return std::less<PointStat<NumberType, Policy>*>{}(a.stat, b.stat);
+        });
+        std::size_t removed = 0;
+        for (const auto& instance : entry.instances) {
+            removed += instance.stat->removeModifier(instance.handle);
+        }
+        entry.instances.clear();
+        entry.alive = false;
+        entry.generation++;
+        free_.push_back(static_cast<uint32_t>(aura));
+        return removed;
+    }
+
+    // Drops every reference to a stat that's about to be destroyed, this one is a full scan
+    std::size_t forget(const PointStat<NumberType, Policy>& stat) 
+    {
+        std::size_t forgotten = 0;
+        for (auto& entry : auras_) {
+            auto& instances = entry.instances;
+            for (std::size_t i = 0; i < instances.size();) {
+                if (instances[i].stat == &stat) {
+                    instances[i] = instances.back();
+                    instances.pop_back();
+                    ++forgotten;
+                }
+                else {
+                    ++i;
+                }
+            }
+        }
+        return forgotten;
+    }
+
+    // How many stats currently have the aura
+    std::size_t affected(AuraId aura) const 
+    {
+        return valid(aura) ? auras_[static_cast<uint32_t>(aura)].instances.size() : 0;
+    }
+
+private:
+
+    struct Instance 
+    {
+        PointStat<NumberType, Policy>* stat;
+        ModifierHandle handle;
+    };
+
+    struct Aura 
+    {
+        Modifier<NumberType> modifier{Modifier<NumberType>::Type::Add, 0};
+        uint32_t generation = 0;
+        bool alive = false;
+        std::vector<Instance> instances;
+    };
+
+    // False once the aura has been destroyed, even if its slot is in use again
+    bool valid(AuraId aura) const 
+    {
+        auto index = static_cast<uint32_t>(aura);
+        return index < auras_.size()
+            and auras_[index].alive
+            and auras_[index].generation == static_cast<uint32_t>(aura >> 32);
+    }
+
+    std::vector<Aura> auras_;
+    std::vector<uint32_t> free_;
+    std::vector<PointStat<NumberType, Policy>*> scratch_;
+};
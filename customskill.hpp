@@ -21,10 +21,18 @@
 // SOFTWARE.
 
 #pragma once
+#include <algorithm>
 #include <concepts>
 #include <limits>
 #include <cmath>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <functional>
+#include <memory>
+#include <mutex>
+#include <span>
 #include <string>
 #include <vector>
 
@@ -46,6 +54,222 @@ namespace Components {
         static constexpr uint64_t PointMax = UINT64_MAX;
         static constexpr uint16_t LevelMax = UINT16_MAX;
 
+        // Fractional points are 32.32 fixed point, the low 32 bits hold the part of a point
+        static constexpr uint8_t FractionBits = 32;
+        static constexpr uint64_t FractionMask = (1ULL << FractionBits) - 1;
+
+        // Point multipliers are 16.16 fixed point, RateOne leaves grants unchanged
+        static constexpr uint32_t RateOne = 1u << 16;
+
+        // Global and per group point multipliers, e.g. for double XP weekends.
+        // Every change publishes a new immutable table with a bumped epoch, so all
+        // worker threads switch over at once, and everything one grant reads comes from one table.
+        // Readers pin the table they use, which records its epoch for the calling thread;
+        // publishing frees the replaced tables no thread has pinned any more, so a server
+        // with scheduled rate events only ever keeps the tables still being read.
+        class RateRegistry {
+        public:
+            static constexpr size_t Groups = 256;
+
+            struct Table {
+                uint64_t epoch = 0;
+                uint32_t global = RateOne;
+                std::array<uint32_t, Groups> group;
+                std::array<uint32_t, Groups> combined;  // global * group, what grants read
+            };
+
+            // Holds the current table for as long as it lives, one per grant or batch.
+            // Pins nest on a thread, the inner ones see the table the outermost one took.
+            class Pin {
+            public:
+                Pin() noexcept : table_(&RateRegistry::pin()) {}
+                ~Pin() { RateRegistry::unpin(); }
+
+                Pin(const Pin&) = delete;
+                Pin& operator=(const Pin&) = delete;
+
+                const Table& operator*() const noexcept { return *table_; }
+                const Table* operator->() const noexcept { return table_; }
+
+            private:
+                const Table* table_;
+            };
+
+            [[nodiscard]]
+            static uint64_t epoch() noexcept
+            {
+                Pin rates;
+                return rates->epoch;
+            }
+
+            [[nodiscard]]
+            static uint32_t rate(uint8_t group) noexcept
+            {
+                Pin rates;
+                return rates->combined[group];
+            }
+
+            // Both return the epoch the change was published under
+            static uint64_t setGlobal(uint32_t rate)
+            {
+                return publish([rate](Table& next) { next.global = rate; });
+            }
+
+            static uint64_t setGroup(uint8_t group, uint32_t rate)
+            {
+                return publish([group, rate](Table& next) { next.group[group] = rate; });
+            }
+
+        private:
+
+            static constexpr uint64_t Idle = UINT64_MAX;
+
+            // The epoch one thread has pinned, Idle when it holds nothing. Records are
+            // never freed, a thread that exits hands its record to the next new reader.
+            struct Reader {
+                std::atomic<uint64_t> epoch{Idle};
+                std::atomic<bool> taken{true};
+                Reader* next = nullptr;
+            };
+
+            struct ThreadState {
+                Reader* reader = claim();
+                const Table* held = nullptr;
+                uint32_t depth = 0;
+
+                ~ThreadState() 
+                {
+                    reader->taken.store(false, std::memory_order_release);
+                }
+            };
+
+            static ThreadState& local() noexcept
+            {
+                thread_local ThreadState state;
+                return state;
+            }
+
+            static Reader* claim()
+            {
+                for (Reader* reader = readers.load(std::memory_order_acquire); reader; reader = reader->next)
+                {
+                    bool expected = false;
+                    if (reader->taken.compare_exchange_strong(expected, true, std::memory_order_acq_rel))
+                    {
+                        return reader;
+                    }
+                }
+                auto* reader = new Reader;
+                reader->next = readers.load(std::memory_order_relaxed);
+                while (not readers.compare_exchange_weak(reader->next, reader, std::memory_order_release, std::memory_order_relaxed))
+                {
+                }
+                return reader;
+            }
+
+            // Records the epoch before trusting the table, and checks the table is still current
+            // afterwards, so a writer either sees the record or we see its new table.
+            static const Table& pin() noexcept
+            {
+                ThreadState& state = local();
+                if (state.depth++ > 0)
+                {
+                    return *state.held;
+                }
+
+                const Table* table = current.load(std::memory_order_seq_cst);
+                while (true)
+                {
+                    state.reader->epoch.store(table->epoch, std::memory_order_seq_cst);
+                    const Table* again = current.load(std::memory_order_seq_cst);
+                    if (again == table)
+                    {
+                        break;
+                    }
+                    table = again;
+                }
+                state.held = table;
+                return *table;
+            }
+
+            static void unpin() noexcept
+            {
+                ThreadState& state = local();
+                if (--state.depth == 0)
+                {
+                    state.held = nullptr;
+                    state.reader->epoch.store(Idle, std::memory_order_release);
+                }
+            }
+
+            static constexpr Table defaults() noexcept
+            {
+                Table table;
+                table.group.fill(RateOne);
+                table.combined.fill(RateOne);
+                return table;
+            }
+
+            template<typename Change>
+            static uint64_t publish(Change&& change)
+            {
+                std::lock_guard lock(writer);
+                auto next = std::make_unique<Table>(*current.load(std::memory_order_relaxed));
+                change(*next);
+                next->epoch++;
+                for (size_t i = 0; i < Groups; ++i)
+                {
+                    uint64_t combined = (static_cast<uint64_t>(next->global) * next->group[i]) >> 16;
+                    next->combined[i] = combined < UINT32_MAX ? static_cast<uint32_t>(combined) : UINT32_MAX;
+                }
+
+                uint64_t published_epoch = next->epoch;
+                current.store(next.get(), std::memory_order_seq_cst);
+                if (latest)
+                {
+                    retired.push_back(std::move(latest));
+                }
+                latest = std::move(next);
+
+                // A table is free once every reader is idle or has pinned something newer
+                uint64_t oldest = Idle;
+                for (Reader* reader = readers.load(std::memory_order_acquire); reader; reader = reader->next)
+                {
+                    oldest = std::min(oldest, reader->epoch.load(std::memory_order_seq_cst));
+                }
+                std::erase_if(retired, [oldest](const std::unique_ptr<Table>& table) { return table->epoch < oldest; });
+                return published_epoch;
+            }
+
+            static const Table initial;
+            static inline std::atomic<const Table*> current{&initial};
+            static inline std::atomic<Reader*> readers{nullptr};
+            static inline std::mutex writer;
+            static inline std::unique_ptr<Table> latest;                // what current points at, unless it's initial
+            static inline std::vector<std::unique_ptr<Table>> retired;  // replaced but maybe still pinned
+        };
+
+        constinit inline const RateRegistry::Table RateRegistry::initial = RateRegistry::defaults();
+
+        // Builds a 32.32 fixed point amount, e.g. fixedPoints(3, 100) for 0.03 points.
+        // Rounds to the nearest 1/2^32 so repeated ticks don't drift low.
+        [[nodiscard]]
+        constexpr uint64_t fixedPoints(uint32_t numerator, uint32_t denominator = 1) noexcept
+        {
+            if (not denominator) return 0;
+            uint64_t whole = static_cast<uint64_t>(numerator / denominator) << FractionBits;
+            uint64_t part = ((static_cast<uint64_t>(numerator % denominator) << FractionBits) + denominator / 2) / denominator;
+            return whole + part;
+        }
+
+        // Describes how fast a skill gains points while the owner is away.
+        // The gain per second is points_per_second + points_per_level * current level,
+        // so leaving points_per_level at 0 gives a flat rate.
+        struct ProgressRate {
+            uint32_t points_per_second = 0;
+            uint32_t points_per_level = 0;
+        };
+
         class CustomSkill {
         public:
 
@@ -94,41 +318,115 @@ namespace Components {
                     return false;
                 }
 
-                auto temp_level = static_cast<uint64_t>(current_level);
-                auto temp_current_points = current_points;
+                grantPoints(scaledPoints(points, pointRate()));
+                return true;
+            }
 
-                while (true) 
+            // Batch form, every skill in the batch sees the same rate table
+            static bool addPoints(std::span<CustomSkill> skills, uint32_t points) noexcept
+            {
+                [[unlikely]]
+                if (not points or skills.empty())
                 {
-                    if (max_level and temp_level >= max_level) 
+                    return false;
+                }
+
+                RateRegistry::Pin rates;
+                for (auto& skill : skills)
+                {
+                    skill.grantPoints(skill.scaledPoints(points, skill.pointRate(*rates)));
+                }
+                return true;
+            }
+
+            // For high frequency ticks that earn less than a point at a time.
+            // Takes 32.32 fixed point and keeps the leftover fraction on the skill
+            // until it adds up to whole points.
+            bool addFractionalPoints(uint64_t fixed_points) noexcept
+            {
+                [[unlikely]]
+                if (not fixed_points)
+                {
+                    return false;
+                }
+
+                uint32_t rate = pointRate();
+                if (rate != RateOne)
+                {
+                    fixed_points = multiplyDivide(fixed_points, rate, RateOne);
+                }
+
+                uint64_t fraction = static_cast<uint64_t>(fractional_points) + (fixed_points & FractionMask);
+                uint64_t whole = (fixed_points >> FractionBits) + (fraction >> FractionBits);
+                fractional_points = static_cast<uint32_t>(fraction);
+                if (whole)
+                {
+                    grantPoints(whole);
+                }
+                return true;
+            }
+
+            // Jumps the skill straight to the state it would be in after training for
+            // the elapsed time, instead of replaying one addPoints call per tick.
+            // The result is the same as granting rate points once per second, where
+            // each second uses the rate of the level the skill had at its start.
+            // pointRate() is applied to the per second rate rather than to each grant.
+            bool addIdleProgress(const ProgressRate& rate, std::chrono::seconds elapsed) noexcept
+            {
+                [[unlikely]]
+                if (elapsed.count() <= 0 or (not rate.points_per_second and not rate.points_per_level))
+                {
+                    return false;
+                }
+
+                // One table for the whole stretch, a rate published halfway through waits for the next grant
+                RateRegistry::Pin rates;
+                auto seconds = static_cast<uint64_t>(elapsed.count());
+                if (not rate.points_per_level)
+                {
+                    return grantPoints(multiplyDivide(saturatingMultiply(rate.points_per_second, seconds), pointRate(*rates), RateOne));
+                }
+
+                // The rate only changes when the level does, so we can jump a whole
+                // level at a time and the loop is bounded by the levels gained.
+                const uint16_t cap = levelCap();
+                while (seconds and (current_level < cap or canPrestige()))
+                {
+                    uint64_t per_second = rate.points_per_second + static_cast<uint64_t>(rate.points_per_level) * current_level;
+                    per_second = multiplyDivide(per_second, pointRate(*rates), RateOne);
+                    [[unlikely]]
+                    if (not per_second)
                     {
-                        temp_current_points = 0;
                         break;
                     }
 
-                    uint64_t points_required = pointsRequired(temp_level + 1);
-                    if (points_required == std::numeric_limits<uint64_t>::max() or points_required == 0)
+                    // Sitting at the cap with a tier left means the next point wraps
+                    uint64_t needed = 0;
+                    if (current_level < cap)
                     {
-                        temp_current_points += points;
-                        break;
+                        uint64_t points_required = pointsRequired(static_cast<uint64_t>(current_level) + 1);
+                        if (points_required == PointMax or points_required == 0)
+                        {
+                            grantPoints(saturatingMultiply(per_second, seconds));
+                            break;
+                        }
+                        needed = points_required > current_points ? points_required - current_points : 0;
                     }
 
-                    uint64_t excess_points = points_required - temp_current_points;
-                    if (points >= excess_points)
+                    uint64_t to_level = needed / per_second + (needed % per_second != 0);
+                    if (to_level == 0)
                     {
-                        points -= excess_points;
-                        temp_level++;
-                        temp_current_points = 0;
+                        to_level = 1;
                     }
-                    else 
+
+                    if (to_level >= seconds)
                     {
-                        temp_current_points += points;
-                        points = 0;
+                        grantPoints(saturatingMultiply(per_second, seconds));
                         break;
                     }
+                    grantPoints(per_second * to_level);
+                    seconds -= to_level;
                 }
-
-                current_points = temp_current_points;
-                current_level = static_cast<uint16_t>(temp_level);
                 return true;
             }
 
@@ -155,13 +453,15 @@ namespace Components {
                     points_to_remove = 0;
                 }
 
-                while (points_to_remove > 0 and temp_level > 0) 
+                auto temp_level_points = level_points;
+                while (points_to_remove > 0 and temp_level > 1) 
                 {
                     auto required_points = pointsRequired(temp_level);
+                    temp_level--; 
+                    temp_level_points = temp_level_points > required_points ? temp_level_points - required_points : 0;
                     if (points_to_remove >= required_points)
                     {
                         points_to_remove -= required_points;
-                        temp_level--; 
                         temp_points = 0;
                     }
                     else 
@@ -172,8 +472,12 @@ namespace Components {
                     }
                 }
 
-                current_level = temp_level > 0 ? static_cast<uint16_t>(temp_level) : 1;
-                current_points = temp_level > 0 ? temp_points : 0;
+                current_level = static_cast<uint16_t>(temp_level);
+                current_points = temp_points;
+                // Taking points off PointMax doesn't give a real total, and changeLevel builds on
+                // this one for the curves it has to walk, so count those again
+                level_points = current_level <= 1 ? 0 : 
+                    level_points == PointMax and not hasClosedForm() ? levelPoints(current_level) : temp_level_points;
                 return true;
             }
 
@@ -185,10 +489,8 @@ namespace Components {
                     return false;
                 }
 
-                uint64_t required = pointsRequired(current_level);
-                double percent = save_progress and required > 0 ? static_cast<double>(current_points) / required : 0.0;
-                current_level = max_level and (levels + current_level) >= max_level ? max_level : levels + current_level;
-                current_points = save_progress ? static_cast<uint64_t>(pointsRequired(current_level) * percent) : 0;
+                uint32_t target = static_cast<uint32_t>(current_level) + levels;
+                changeLevel(static_cast<uint16_t>(std::min<uint32_t>(target, levelCap())), save_progress);
                 return true;
             }
 
@@ -200,10 +502,39 @@ namespace Components {
                 {
                     return false;
                 }
-                uint64_t required = pointsRequired(current_level);
-                double percent = save_progress and required > 0 ? static_cast<double>(current_points) / required : 0.0;
-                current_level = std::max<uint16_t>(1, current_level - levels);
-                current_points = save_progress ? static_cast<uint64_t>(pointsRequired(current_level) * percent) : 0;
+
+                changeLevel(current_level > levels ? current_level - levels : 1, save_progress);
+                return true;
+            }
+
+            // Batch forms for handing out level rewards, same rules as the single versions
+            static bool addLevels(std::span<CustomSkill> skills, uint16_t levels, bool save_progress = false) noexcept
+            {
+                [[unlikely]]
+                if (not levels or skills.empty())
+                {
+                    return false;
+                }
+
+                for (auto& skill : skills)
+                {
+                    skill.addLevels(levels, save_progress);
+                }
+                return true;
+            }
+
+            static bool removeLevels(std::span<CustomSkill> skills, uint16_t levels, bool save_progress = false) noexcept
+            {
+                [[unlikely]]
+                if (not levels or skills.empty())
+                {
+                    return false;
+                }
+
+                for (auto& skill : skills)
+                {
+                    skill.removeLevels(levels, save_progress);
+                }
                 return true;
             }
 
@@ -211,12 +542,11 @@ namespace Components {
             Number percent() const noexcept 
             {
                 static_assert(std::is_arithmetic_v<Number>, "percent() requires an arithmetic return type");
-                auto required = pointsRequired(level);
+                auto required = pointsRequired(static_cast<uint64_t>(current_level) + 1);
 
                 [[likely]] 
                 if (current_points and required)
                 {
-                    auto level = (current_level + 1);
                     auto raw_percent = (current_points * 100ULL) / required;
                     return static_cast<Number>(raw_percent);
                 }
@@ -224,24 +554,83 @@ namespace Components {
                 return static_cast<Number>(0);
             }
 
+            // Lets the skill wrap back to level 1 when it reaches its cap, up to max_tiers times.
+            // Every tier adds tier_bonus (16.16 fixed point) on top of a 1x point multiplier.
+            void setPrestige(uint16_t max_tiers, uint32_t tier_bonus = 0) noexcept
+            {
+                max_prestige = max_tiers;
+                prestige_bonus = tier_bonus;
+                tier_points = levelPoints(levelCap());
+            }
+
+            [[nodiscard]]
+            constexpr uint16_t prestige() const noexcept
+            {
+                return prestige_tier;
+            }
+
+            // Every point earned across all tiers, O(1) so it can be used as a rank key
+            [[nodiscard]]
+            constexpr uint64_t totalPoints() const noexcept
+            {
+                return saturatingAdd(saturatingMultiply(prestige_tier, tier_points), saturatingAdd(level_points, current_points));
+            }
+
+            // The multiplier applied to every grant, 16.16 fixed point.
+            // Combines the prestige tier bonus with the registry rate for our group.
+            [[nodiscard]]
+            uint32_t pointRate() const noexcept
+            {
+                RateRegistry::Pin rates;
+                return pointRate(*rates);
+            }
+
+            [[nodiscard]]
+            uint32_t pointRate(const RateRegistry::Table& rates) const noexcept
+            {
+                uint64_t tier_rate = RateOne + static_cast<uint64_t>(prestige_tier) * prestige_bonus;
+                uint64_t rate = multiplyDivide(tier_rate, rates.combined[rate_group], RateOne);
+                return rate < UINT32_MAX ? static_cast<uint32_t>(rate) : UINT32_MAX;
+            }
+
+            // Which RateRegistry group multiplier this skill uses, 0 by default
+            void setRateGroup(uint8_t group) noexcept
+            {
+                rate_group = group;
+            }
+
             void setBonus(int16_t level) noexcept
             {
                 bonus_level = level;
             }
 
+            // The part of a point banked by addFractionalPoints, in 1/2^32 units
+            [[nodiscard]]
+            constexpr uint32_t fractionalPoints() const noexcept
+            {
+                return fractional_points;
+            }
+
         private:
 
             uint64_t current_points = 0;
+            uint64_t level_points = 0;  // Points it took to reach current_level from level 1
+            uint64_t tier_points = 0;   // Points in one full prestige tier, set by setPrestige
+            uint32_t fractional_points = 0;
+            uint32_t prestige_bonus = 0;
             uint16_t factor_x = 1;
             uint16_t factor_y = 1;
             uint16_t factor_z = 1;
             uint16_t current_level = 1;
             int16_t bonus_level = 0;
             uint16_t max_level = 0;  // Maximum allowed level, if 0, limit is numerical limit;
+            uint16_t prestige_tier = 0;
+            uint16_t max_prestige = 0;
             FormulaType formula = FormulaType::EXPONENTIAL;
+            uint8_t rate_group = 0;
 
             [[nodiscard]] 
-            uint64_t pointsRequired(uint64_t target_level)
+            uint64_t pointsRequired(uint64_t target_level) const
             {
                 switch (formula) 
                 {
@@ -257,6 +646,322 @@ namespace Components {
                 return 0;
             }
 
+            // Even with no max_level set we can't go beyond what a uint16_t holds
+            [[nodiscard]]
+            constexpr uint16_t levelCap() const noexcept
+            {
+                return max_level ? max_level : LevelMax;
+            }
+
+            bool grantPoints(uint64_t points) noexcept
+            {
+                [[unlikely]]
+                if (not points) 
+                {
+                    return false;
+                }
+
+                // Crossing the cap rolls into the next tier, and whole tiers are
+                // skipped with a division instead of levelling through them.
+                if (canPrestige())
+                {
+                    uint64_t done = saturatingAdd(level_points, current_points);
+                    uint64_t to_cap = tier_points > done ? tier_points - done : 0;
+                    if (points >= to_cap)
+                    {
+                        points -= to_cap;
+                        uint64_t extra = std::min<uint64_t>(points / tier_points, max_prestige - prestige_tier - 1);
+                        points -= extra * tier_points;
+                        prestige_tier += static_cast<uint16_t>(extra + 1);
+                        current_level = 1;
+                        current_points = 0;
+                        level_points = 0;
+                        if (not points)
+                        {
+                            return true;
+                        }
+                    }
+                }
+
+                const uint16_t cap = levelCap();
+                uint64_t total = hasClosedForm() and current_level < cap ? 
+                    saturatingAdd(saturatingAdd(pointsToReach(current_level), current_points), points) : PointMax;
+
+                // Binary search the final level against the running total instead
+                // of walking every level in between. If the total doesn't fit we let the loop handle it.
+                if (total < PointMax)
+                {
+                    uint64_t low = current_level;
+                    uint64_t high = cap;
+                    while (low < high)
+                    {
+                        uint64_t mid = low + (high - low + 1) / 2;
+                        uint64_t reach = pointsToReach(mid);
+                        if (reach < PointMax and reach <= total)
+                        {
+                            low = mid;
+                        }
+                        else 
+                        {
+                            high = mid - 1;
+                        }
+                    }
+
+                    current_level = static_cast<uint16_t>(low);
+                    level_points = pointsToReach(low);
+                    current_points = low >= cap ? 0 : total - level_points;
+                    return true;
+                }
+
+                auto temp_level = static_cast<uint64_t>(current_level);
+                auto temp_current_points = current_points;
+                auto temp_level_points = level_points;
+
+                while (true) 
+                {
+                    if (temp_level >= cap) 
+                    {
+                        temp_current_points = 0;
+                        break;
+                    }
+
+                    uint64_t points_required = pointsRequired(temp_level + 1);
+                    if (points_required == std::numeric_limits<uint64_t>::max() or points_required == 0)
+                    {
+                        temp_current_points += points;
+                        break;
+                    }
+
+                    uint64_t excess_points = points_required - temp_current_points;
+                    if (points >= excess_points)
+                    {
+                        points -= excess_points;
+                        temp_level++;
+                        temp_current_points = 0;
+                        temp_level_points = saturatingAdd(temp_level_points, points_required);
+                    }
+                    else 
+                    {
+                        temp_current_points += points;
+                        points = 0;
+                        break;
+                    }
+                }
+
+                current_points = temp_current_points;
+                current_level = static_cast<uint16_t>(temp_level);
+                level_points = temp_level_points;
+                return true;
+            }
+
+            // Moves to target_level, optionally keeping the same fraction of the way
+            // to the next level. Integer only so every platform lands on the same value.
+            void changeLevel(uint16_t target_level, bool save_progress) noexcept
+            {
+                uint64_t progress = current_points;
+                uint64_t old_required = pointsRequired(static_cast<uint64_t>(current_level) + 1);
+
+                level_points = levelPoints(target_level, current_level, level_points);
+                current_level = target_level;
+                current_points = 0;
+                if (save_progress and progress and old_required and current_level < levelCap())
+                {
+                    uint64_t new_required = pointsRequired(static_cast<uint64_t>(current_level) + 1);
+                    current_points = multiplyDivide(std::min(progress, old_required), new_required, old_required);
+                }
+            }
+
+            [[nodiscard]]
+            constexpr bool canPrestige() const noexcept
+            {
+                return prestige_tier < max_prestige and tier_points > 0 and tier_points < PointMax;
+            }
+
+            // Same as pointsToReach, but walks the levels for curves without a closed form.
+            // PointMax means the level can't be reached through normal levelling.
+            // from_level and from_points are a level we already know the total for, so
+            // only the levels between it and target_level are walked.
+            [[nodiscard]]
+            uint64_t levelPoints(uint16_t target_level, uint16_t from_level = 1, uint64_t from_points = 0) const noexcept
+            {
+                if (hasClosedForm())
+                {
+                    return pointsToReach(target_level);
+                }
+
+                // Going down only works if every level below from_level was reachable,
+                // otherwise we don't know what to take off and start over from level 1.
+                if (from_level <= 1 or from_points == PointMax)
+                {
+                    from_level = 1;
+                    from_points = 0;
+                }
+                else if (target_level < from_level)
+                {
+                    uint64_t sum = from_points;
+                    for (uint64_t level = from_level; level > target_level and level > 1; --level)
+                    {
+                        uint64_t points_required = pointsRequired(level);
+                        sum = sum > points_required ? sum - points_required : 0;
+                    }
+                    return sum;
+                }
+
+                uint64_t sum = from_points;
+                for (uint64_t level = static_cast<uint64_t>(from_level) + 1; level <= target_level; ++level)
+                {
+                    uint64_t points_required = pointsRequired(level);
+                    [[unlikely]]
+                    if (points_required == PointMax or points_required == 0)
+                    {
+                        return PointMax;
+                    }
+                    sum = saturatingAdd(sum, points_required);
+                }
+                return sum;
+            }
+
+            // Applies a pointRate() to a grant, the part of a point it leaves over
+            // goes into the fractional bank so nothing is lost to rounding.
+            uint64_t scaledPoints(uint64_t points, uint32_t rate) noexcept
+            {
+                [[likely]]
+                if (rate == RateOne)
+                {
+                    return points;
+                }
+
+                uint64_t whole = multiplyDivide(points, rate, RateOne);
+                uint64_t fraction = static_cast<uint64_t>(fractional_points) + (((points * rate) & (RateOne - 1)) << 16);
+                fractional_points = static_cast<uint32_t>(fraction);
+                return saturatingAdd(whole, fraction >> FractionBits);
+            }
+
+            // Only the polynomial and exponential curves have a closed form sum,
+            // and they are non decreasing, so a positive first step means every step is.
+            [[nodiscard]]
+            bool hasClosedForm() const noexcept
+            {
+                switch (formula)
+                {
+                    case FormulaType::EXPONENTIAL: if (not factor_y) return false; [[fallthrough]];
+                    case FormulaType::LINEAR:
+                    case FormulaType::QUADRATIC:
+                    case FormulaType::CUBIC: return pointsRequired(2) > 0;
+                    default: return false;
+                }
+            }
+
+            // Total points needed to go from the start of level 1 to the start of target_level.
+            // Only valid when hasClosedForm() is true, saturates at PointMax.
+            [[nodiscard]]
+            uint64_t pointsToReach(uint64_t target_level) const noexcept
+            {
+                uint64_t sum = pointsSum(target_level);
+                [[unlikely]]
+                if (sum == PointMax) return PointMax;
+                return sum - pointsSum(1);
+            }
+
+            // Sum of pointsRequired(1) through pointsRequired(n)
+            [[nodiscard]]
+            uint64_t pointsSum(uint64_t n) const noexcept
+            {
+                auto x = static_cast<uint64_t>(factor_x);
+                auto y = static_cast<uint64_t>(factor_y);
+                auto z = static_cast<uint64_t>(factor_z);
+
+                // n never goes past LevelMax + 1 so these can't overflow
+                uint64_t triangle = n * (n + 1) / 2;
+                switch (formula)
+                {
+                    case FormulaType::LINEAR:
+                    {
+                        return saturatingAdd(saturatingMultiply(saturatingMultiply(x, y), n), saturatingMultiply(z, triangle));
+                    }
+
+                    case FormulaType::QUADRATIC:
+                    {
+                        uint64_t squares = triangle * (2 * n + 1) / 3;
+                        return saturatingAdd(saturatingAdd(saturatingMultiply(x, squares), saturatingMultiply(y, triangle)), saturatingMultiply(z, n));
+                    }
+
+                    case FormulaType::CUBIC:
+                    {
+                        return saturatingMultiply(x, saturatingMultiply(triangle, triangle));
+                    }
+
+                    case FormulaType::EXPONENTIAL:
+                    {
+                        // Every level up to z + 1 costs x, after that it's x * y^k
+                        uint64_t flat_levels = z + 1;
+                        if (n <= flat_levels) return saturatingMultiply(x, n);
+
+                        uint64_t steps = n - flat_levels;
+                        uint64_t geometric = steps;
+                        if (y > 1)
+                        {
+                            uint64_t power = integerPow(y, steps);
+                            [[unlikely]]
+                            if (power == PointMax) return PointMax;
+                            geometric = saturatingMultiply(y, (power - 1) / (y - 1));
+                        }
+                        return saturatingAdd(saturatingMultiply(x, flat_levels), saturatingMultiply(x, geometric));
+                    }
+
+                    default: return PointMax;
+                }
+            }
+
+            static constexpr uint64_t saturatingAdd(uint64_t a, uint64_t b) noexcept
+            {
+                return a > PointMax - b ? PointMax : a + b;
+            }
+
+            static constexpr uint64_t saturatingMultiply(uint64_t a, uint64_t b) noexcept
+            {
+                return b and a > PointMax / b ? PointMax : a * b;
+            }
+
+            // floor(a * b / c) with a 128 bit intermediate, saturates at PointMax.
+            static constexpr uint64_t multiplyDivide(uint64_t a, uint64_t b, uint64_t c) noexcept
+            {
+                [[unlikely]]
+                if (c == 0) return PointMax;
+#if defined(__SIZEOF_INT128__)
+                unsigned __int128 result = static_cast<unsigned __int128>(a) * b / c;
+                return result > PointMax ? PointMax : static_cast<uint64_t>(result);
+#else
+                // Schoolbook 64x64 multiply into two halves, then long division.
+                uint64_t a_lo = a & 0xFFFFFFFF, a_hi = a >> 32;
+                uint64_t b_lo = b & 0xFFFFFFFF, b_hi = b >> 32;
+                uint64_t lo_lo = a_lo * b_lo;
+                uint64_t hi_lo = a_hi * b_lo;
+                uint64_t lo_hi = a_lo * b_hi;
+                uint64_t cross = (lo_lo >> 32) + (hi_lo & 0xFFFFFFFF) + lo_hi;
+                uint64_t high = a_hi * b_hi + (hi_lo >> 32) + (cross >> 32);
+                uint64_t low = (cross << 32) | (lo_lo & 0xFFFFFFFF);
+
+                [[unlikely]]
+                if (high >= c) return PointMax;
+
+                uint64_t quotient = 0;
+                for (int bit = 63; bit >= 0; --bit)
+                {
+                    bool carry = high >> 63;
+                    high = (high << 1) | (low >> 63);
+                    low <<= 1;
+                    quotient <<= 1;
+                    if (carry or high >= c)
+                    {
+                        high -= c;
+                        quotient |= 1;
+                    }
+                }
+                return quotient;
+#endif
+            }
+
             static constexpr uint64_t integerSqrt(uint64_t n)
             {
                 uint64_t left = 0, right = n, ans = 0;
@@ -348,7 +1053,7 @@ namespace Components {
             }
 
             [[nodiscard("This is an internal method that should only be called when the return value is intended for use.")]]
-            constexpr uint64_t exponentialGrowth(uint64_t target_level)
+            constexpr uint64_t exponentialGrowth(uint64_t target_level) const
             {
                 auto x = static_cast<uint64_t>(factor_x);
                 auto y = static_cast<uint64_t>(factor_y);
@@ -0,0 +1,342 @@
+// MIT License
+
+// Author : Codinablack@github.com
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <vector>
+#include "pointbasedstat.hpp"
+
+// Identifies a scheduled expiry in a ModifierTimerWheel, works like ModifierHandle
+struct TimerHandle {
+    uint32_t index = 0;
+    uint32_t generation = 0;
+
+    explicit operator bool() const { return generation != 0; }
+    bool operator==(const TimerHandle&) const = default;
+};
+
+// Expires timed modifiers for a whole world or shard.
+// It's a hierarchical timing wheel, 4 levels of 256 slots, so scheduling and
+// cancelling are O(1) and a tick only touches the modifiers that actually expire
+// (plus the odd cascade), instead of scanning every active buff.
+// Time is whatever tick count the owner advances it with.
+// The wheel keeps raw pointers to the stats, so a stat must outlive its timers
+// or have them dropped with cancelAll first.
+template<PositiveNumber NumberType, class Policy = OverflowPolicy::Clamp>
+class ModifierTimerWheel {
+public:
+
+    struct TimedModifier 
+    {
+        ModifierHandle modifier;
+        TimerHandle timer;
+    };
+
+    explicit ModifierTimerWheel(uint64_t now = 0) 
+        : now_(now)
+    {
+        for (auto& level : buckets_) {
+            level.fill(NoNode);
+        }
+    }
+
+    // Adds the modifier to the stat and schedules its removal duration ticks from now.
+    // If the stat rejects the modifier nothing is scheduled and both handles are empty.
+    // Reapplying a sourced modifier only ever touches an expiry that already exists:
+    // stacking, refreshing or replacing pushes it out, a rejected reapply leaves it alone,
+    // and an instance that was never timed (a permanent item, say) stays permanent.
+    TimedModifier apply(PointStat<NumberType, Policy>& stat, const Modifier<NumberType>& modifier, uint64_t duration) 
+    {
+        StackOutcome outcome;
+        ModifierHandle handle = stat.addModifier(modifier, outcome);
+        if (not handle) {
+            return TimedModifier{};
+        }
+
+        if (outcome == StackOutcome::Added) {
+            TimerHandle timer = schedule(stat, handle, duration);
+            stat.setTimer(handle, timer.index);
+            return TimedModifier{handle, timer};
+        }
+
+        TimerHandle timer = timerOf(stat, handle);
+        if (timer and outcome != StackOutcome::Rejected) {
+            reschedule(timer, duration);
+        }
+        return TimedModifier{handle, timer};
+    }
+
+    // Schedules removal of a modifier that's already on the stat
+    TimerHandle schedule(PointStat<NumberType, Policy>& stat, ModifierHandle handle, uint64_t duration) 
+    {
+        uint32_t index = acquireNode();
+        auto& node = nodes_[index];
+        node.stat = &stat;
+        node.modifier = handle;
+        node.deadline = now_ + std::max<uint64_t>(duration, 1);
+        link(index);
+        ++active_;
+        return TimerHandle{index, node.generation};
+    }
+
+    // Moves an existing expiry to duration ticks from now, e.g. when a buff is refreshed
+    bool reschedule(TimerHandle timer, uint64_t duration) 
+    {
+        if (not isActive(timer)) {
+            return false;
+        }
+        unlink(timer.index);
+        nodes_[timer.index].deadline = now_ + std::max<uint64_t>(duration, 1);
+        link(timer.index);
+        return true;
+    }
+
+    // Drops the expiry, the modifier stays on the stat
+    bool cancel(TimerHandle timer) 
+    {
+        if (not isActive(timer)) {
+            return false;
+        }
+        unlink(timer.index);
+        releaseNode(timer.index);
+        return true;
+    }
+
+    // Drops every expiry pointing at the stat, call this before destroying it.
+    // This is a full scan, it's meant for despawns rather than the hot path.
+    std::size_t cancelAll(const PointStat<NumberType, Policy>& stat) 
+    {
+        std::size_t cancelled = 0;
+        for (uint32_t index = 0; index < nodes_.size(); ++index) {
+            if (nodes_[index].stat == &stat and nodes_[index].active) {
+                unlink(index);
+                releaseNode(index);
+                ++cancelled;
+            }
+        }
+        return cancelled;
+    }
+
+    // The expiry this wheel scheduled for a modifier through apply, if it's still pending
+    TimerHandle timerOf(const PointStat<NumberType, Policy>& stat, ModifierHandle handle) const 
+    {
+        uint32_t index = stat.timer(handle);
+        if (index < nodes_.size() and nodes_[index].active 
+            and nodes_[index].stat == &stat and nodes_[index].modifier == handle) {
+            return TimerHandle{index, nodes_[index].generation};
+        }
+        return TimerHandle{};
+    }
+
+    bool isActive(TimerHandle timer) const 
+    {
+        return timer.index < nodes_.size() and nodes_[timer.index].active 
+            and nodes_[timer.index].generation == timer.generation;
+    }
+
+    // Advances the wheel to now and removes every modifier that expired on the way.
+    // Expired modifiers are grouped by stat so each stat recalculates once.
+    // Returns how many timers fired.
+    std::size_t advance(uint64_t now) 
+    {
+        expired_.clear();
+        while (now_ < now) {
+            // Nothing left to fire, so there's no reason to walk the empty slots
+            if (active_ == 0) {
+                now_ = now;
+                break;
+            }
+            tick();
+        }
+
+        if (expired_.empty()) {
+            return 0;
+        }
+
+        std::sort(expired_.begin(), expired_.end(), [](const Expired& a, const Expired& b) {
+            return std::less<const void*>{}(a.stat, b.stat);
+        });
+
+        handles_.clear();
+        for (std::size_t i = 0; i < expired_.size(); ++i) {
+            handles_.push_back(expired_[i].modifier);
+            if (i + 1 == expired_.size() or expired_[i + 1].stat != expired_[i].stat) {
+                expired_[i].stat->removeModifiers(handles_);
+                handles_.clear();
+            }
+        }
+        return expired_.size();
+    }
+
+    uint64_t now() const 
+    {
+        return now_;
+    }
+
+    std::size_t size() const 
+    {
+        return active_;
+    }
+
+private:
+
+    static constexpr uint32_t NoNode = UINT32_MAX;
+    static constexpr uint32_t SlotBits = 8;
+    static constexpr uint32_t SlotCount = 1u << SlotBits;
+    static constexpr uint32_t SlotMask = SlotCount - 1;
+    static constexpr uint32_t LevelCount = 4;
+
+    struct Node 
+    {
+        PointStat<NumberType, Policy>* stat = nullptr;
+        ModifierHandle modifier;
+        uint64_t deadline = 0;
+        uint32_t prev = NoNode;
+        uint32_t next = NoNode;     // also the free list link
+        uint32_t generation = 1;
+        uint16_t bucket = 0;        // level * SlotCount + slot
+        bool active = false;
+    };
+
+    struct Expired 
+    {
+        PointStat<NumberType, Policy>* stat;
+        ModifierHandle modifier;
+    };
+
+    uint32_t acquireNode() 
+    {
+        if (free_node_ != NoNode) {
+            uint32_t index = free_node_;
+            free_node_ = nodes_[index].next;
+            nodes_[index].active = true;
+            return index;
+        }
+        nodes_.emplace_back();
+        nodes_.back().active = true;
+        return static_cast<uint32_t>(nodes_.size() - 1);
+    }
+
+    void releaseNode(uint32_t index) 
+    {
+        auto& node = nodes_[index];
+        if (++node.generation == 0) {
+            node.generation = 1;
+        }
+        node.active = false;
+        node.stat = nullptr;
+        node.next = free_node_;
+        free_node_ = index;
+        --active_;
+    }
+
+    // Picks the lowest level whose range covers the deadline. Anything further out
+    // than the top level can hold parks in it and is looked at again when it cascades.
+    void link(uint32_t index) 
+    {
+        auto& node = nodes_[index];
+        uint64_t delta = node.deadline > now_ ? node.deadline - now_ : 0;
+        uint32_t level = 0;
+        while (level + 1 < LevelCount and delta >= (uint64_t{1} << (SlotBits * (level + 1)))) {
+            ++level;
+        }
+
+        uint64_t target = node.deadline;
+        if (delta >= (uint64_t{1} << (SlotBits * LevelCount))) {
+            target = now_ + (uint64_t{1} << (SlotBits * LevelCount)) - 1;
+        }
+        uint32_t slot = static_cast<uint32_t>(target >> (SlotBits * level)) & SlotMask;
+
+        uint32_t& head = buckets_[level][slot];
+        node.bucket = static_cast<uint16_t>(level * SlotCount + slot);
+        node.prev = NoNode;
+        node.next = head;
+        if (head != NoNode) {
+            nodes_[head].prev = index;
+        }
+        head = index;
+    }
+
+    void unlink(uint32_t index) 
+    {
+        auto& node = nodes_[index];
+        if (node.prev != NoNode) {
+            nodes_[node.prev].next = node.next;
+        }
+        else {
+            buckets_[node.bucket / SlotCount][node.bucket % SlotCount] = node.next;
+        }
+        if (node.next != NoNode) {
+            nodes_[node.next].prev = node.prev;
+        }
+    }
+
+    // Re-files every timer in the level's current slot into the levels below
+    void cascade(uint32_t level) 
+    {
+        uint32_t slot = static_cast<uint32_t>(now_ >> (SlotBits * level)) & SlotMask;
+        uint32_t index = buckets_[level][slot];
+        buckets_[level][slot] = NoNode;
+        while (index != NoNode) {
+            uint32_t next = nodes_[index].next;
+            link(index);
+            index = next;
+        }
+    }
+
+    void tick() 
+    {
+        ++now_;
+        for (uint32_t level = 1; level < LevelCount; ++level) {
+            if ((now_ >> (SlotBits * (level - 1))) & SlotMask) {
+                break;
+            }
+            cascade(level);
+        }
+
+        uint32_t slot = static_cast<uint32_t>(now_) & SlotMask;
+        uint32_t index = buckets_[0][slot];
+        buckets_[0][slot] = NoNode;
+        while (index != NoNode) {
+            uint32_t next = nodes_[index].next;
+            auto& node = nodes_[index];
+            if (node.deadline <= now_) {
+                expired_.push_back(Expired{node.stat, node.modifier});
+                releaseNode(index);
+            }
+            else {
+                link(index);
+            }
+            index = next;
+        }
+    }
+
+    std::array<std::array<uint32_t, SlotCount>, LevelCount> buckets_;
+    std::vector<Node> nodes_;
+    std::vector<Expired> expired_;
+    std::vector<ModifierHandle> handles_;
+    uint64_t now_;
+    std::size_t active_ = 0;
+    uint32_t free_node_ = NoNode;
+};
@@ -20,13 +20,27 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 // SOFTWARE.
 
+#pragma once
 #include <concepts>
 #include <vector>
 #include <memory>
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <numeric>
+#include <span>
 #include <stdexcept>
+#include <cassert>
 #include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <unordered_map>
 
 template<class T>
 concept PositiveNumber =
@@ -36,21 +50,599 @@ concept PositiveNumber =
     // prevents usage of bool and char
     sizeof(T) >= 2;
 
+// What a PointStat does when a value would leave its range, picked at compile time so
+// the unused checks cost nothing. Every policy answers the same questions:
+//  Checked           whether out of range values are looked for at all
+//  Branchless        add/remove clamp with min/max style selects instead of branches
+//  invalidMax        the constructor was given a max of 0. This one is asked under every
+//                    policy, and if it returns max is raised to 1, a max of 0 is never kept
+//  invalidModifier   Modifier::make was given a value the modifier can't work with
+//  modifier          a sequential modifier would overflow max or take it to 0, returns the
+//                    new max or 0 to refuse the modifier
+// add/remove always stop at max and 0 whatever the policy, overhealing and overkill are
+// normal play, not range errors. Aggregate mode always clamps max to [1, numeric max],
+// it has no overflow to report.
+namespace OverflowPolicy {
+
+    // What PointStat has always done, a bad max throws and modifiers that would overflow are refused
+    struct Clamp {
+        static constexpr bool Checked = true;
+        static constexpr bool Branchless = false;
+
+        static void invalidMax() 
+        {
+            throw std::invalid_argument("PointStat max must be positive");
+        }
+
+        static void invalidModifier() 
+        {
+            // The Modifier constructor patches the value up
+        }
+
+        template<class N>
+        static N modifier(N, N) 
+        {
+            return 0;
+        }
+    };
+
+    // Like Clamp, but add/remove are branch free and modifiers saturate instead of being refused
+    struct Saturate : Clamp {
+        static constexpr bool Branchless = true;
+
+        template<class N>
+        static N modifier(N, N limit) 
+        {
+            return limit;
+        }
+    };
+
+    // A bad max or modifier value and modifier overflow are errors
+    struct Throw : Clamp {
+        static void invalidModifier() 
+        {
+            throw std::invalid_argument("Modifier value out of range");
+        }
+
+        template<class N>
+        static N modifier(N, N) 
+        {
+            throw std::overflow_error("Modifier would overflow PointStat max");
+        }
+    };
+
+    // Strict in debug builds, modifiers go unchecked once NDEBUG is set (a max of 0 is still raised to 1)
+    struct AssertOnly {
+#ifdef NDEBUG
+        static constexpr bool Checked = false;
+        static constexpr bool Branchless = true;
+#else
+        static constexpr bool Checked = true;
+        static constexpr bool Branchless = false;
+#endif
+
+        static void invalidMax() 
+        {
+            assert(false and "PointStat max must be positive");
+        }
+
+        static void invalidModifier() 
+        {
+            assert(false and "Modifier value out of range");
+        }
+
+        template<class N>
+        static N modifier(N, N limit) 
+        {
+            assert(false and "Modifier would overflow PointStat max");
+            return limit;
+        }
+    };
+
+    // The caller promises modifiers never take max out of range, they just wrap if they do.
+    // add/remove still clamp, without branches
+    struct Unchecked {
+        static constexpr bool Checked = false;
+        static constexpr bool Branchless = true;
+
+        static void invalidMax() {}
+        static void invalidModifier() {}
+
+        template<class N>
+        static N modifier(N wrapped, N) 
+        {
+            return wrapped;
+        }
+    };
+}
+
 // Forward declaration
-template<PositiveNumber NumberType>
+template<PositiveNumber NumberType, class Policy = OverflowPolicy::Clamp>
 class PointStat;
 
+// Integer helpers shared by the stat classes. Everything is exact and
+// deterministic, no floating point, so every platform gets the same bits.
+namespace StatMath {
+    // Percentages are in basis points, 10000 is 100%
+    static constexpr uint32_t BasisPointsOne = 10000;
+
+    constexpr uint64_t saturatingAdd(uint64_t a, uint64_t b) 
+    {
+        return a > UINT64_MAX - b ? UINT64_MAX : a + b;
+    }
+
+    constexpr uint64_t saturatingMultiply(uint64_t a, uint64_t b) 
+    {
+        return b and a > UINT64_MAX / b ? UINT64_MAX : a * b;
+    }
+
+    // floor(a * b / c) with a 128 bit intermediate. overflow says whether the result didn't fit
+    // in 64 bits (or c was 0), UINT64_MAX is returned then, so a real UINT64_MAX result is
+    // still told apart from a saturated one.
+    constexpr uint64_t multiplyDivide(uint64_t a, uint64_t b, uint64_t c, bool& overflow) 
+    {
+        overflow = false;
+        if (c == 0) {
+            overflow = true;
+            return UINT64_MAX;
+        }
+        // Stats up to 32 bits and basis point factors land here, one plain 64 bit division
+        if (((a | b) >> 32) == 0) {
+            return a * b / c;
+        }
+#if defined(__SIZEOF_INT128__)
+        unsigned __int128 result = static_cast<unsigned __int128>(a) * b / c;
+        overflow = result > UINT64_MAX;
+        return overflow ? UINT64_MAX : static_cast<uint64_t>(result);
+#else
+        // Schoolbook 64x64 multiply into two halves, then long division
+        uint64_t a_lo = a & 0xFFFFFFFF, a_hi = a >> 32;
+        uint64_t b_lo = b & 0xFFFFFFFF, b_hi = b >> 32;
+        uint64_t lo_lo = a_lo * b_lo;
+        uint64_t hi_lo = a_hi * b_lo;
+        uint64_t lo_hi = a_lo * b_hi;
+        uint64_t cross = (lo_lo >> 32) + (hi_lo & 0xFFFFFFFF) + lo_hi;
+        uint64_t high = a_hi * b_hi + (hi_lo >> 32) + (cross >> 32);
+        uint64_t low = (cross << 32) | (lo_lo & 0xFFFFFFFF);
+
+        if (high >= c) {
+            overflow = true;
+            return UINT64_MAX;
+        }
+
+        uint64_t quotient = 0;
+        for (int bit = 63; bit >= 0; --bit) {
+            bool carry = high >> 63;
+            high = (high << 1) | (low >> 63);
+            low <<= 1;
+            quotient <<= 1;
+            if (carry or high >= c) {
+                high -= c;
+                quotient |= 1;
+            }
+        }
+        return quotient;
+#endif
+    }
+
+    // Same, for callers that are happy with saturating at UINT64_MAX
+    constexpr uint64_t multiplyDivide(uint64_t a, uint64_t b, uint64_t c) 
+    {
+        bool overflow = false;
+        return multiplyDivide(a, b, c, overflow);
+    }
+
+    // value * to / from rounded down, exact for every width, for keeping current at the same
+    // fraction of max when max moves from `from` to `to`. Only integers, so it's bit identical
+    // on every platform. value must not exceed from, which keeps the result within to.
+    template<class NumberType>
+    constexpr NumberType rescale(NumberType value, NumberType to, NumberType from) 
+    {
+        if constexpr (sizeof(NumberType) <= 4) {
+            return static_cast<NumberType>(static_cast<uint64_t>(value) * to / from);
+        }
+        else {
+            return static_cast<NumberType>(multiplyDivide(value, to, from));
+        }
+    }
+}
+
+
+// A vector that keeps its first Inline elements inside the object and only
+// goes to the heap once it outgrows them. It's limited to trivially copyable
+// types so growing, copying and erasing are all plain memory moves.
+template<class T, std::size_t Inline>
+class SmallVector {
+    static_assert(std::is_trivially_copyable_v<T>, "SmallVector only holds trivially copyable types");
+    static_assert(Inline > 0, "SmallVector needs at least one inline element");
+
+public:
+    SmallVector() = default;
+
+    SmallVector(const SmallVector& other) 
+    {
+        reserve(other.size_);
+        std::memcpy(data(), other.data(), other.size_ * sizeof(T));
+        size_ = other.size_;
+    }
+
+    SmallVector(SmallVector&& other) noexcept 
+    {
+        take(other);
+    }
+
+    SmallVector& operator=(const SmallVector& other) 
+    {
+        if (this != &other) 
+        {
+            clear();
+            reserve(other.size_);
+            std::memcpy(data(), other.data(), other.size_ * sizeof(T));
+            size_ = other.size_;
+        }
+        return *this;
+    }
+
+    SmallVector& operator=(SmallVector&& other) noexcept 
+    {
+        if (this != &other) 
+        {
+            release();
+            take(other);
+        }
+        return *this;
+    }
+
+    ~SmallVector() 
+    {
+        release();
+    }
+
+    T* data() { return heap_ ? heap_ : reinterpret_cast<T*>(inline_); }
+    const T* data() const { return heap_ ? heap_ : reinterpret_cast<const T*>(inline_); }
+    T* begin() { return data(); }
+    T* end() { return data() + size_; }
+    const T* begin() const { return data(); }
+    const T* end() const { return data() + size_; }
+    T& operator[](std::size_t index) { return data()[index]; }
+    const T& operator[](std::size_t index) const { return data()[index]; }
+    T& back() { return data()[size_ - 1]; }
+    std::size_t size() const { return size_; }
+    std::size_t capacity() const { return capacity_; }
+    bool empty() const { return size_ == 0; }
+
+    void push_back(const T& value) 
+    {
+        if (size_ == capacity_) 
+        {
+            // value may live in the buffer reserve is about to free, push_back(v[0]) say
+            const T copy = value;
+            reserve(capacity_ * 2);
+            std::memcpy(static_cast<void*>(data() + size_), &copy, sizeof(T));
+        }
+        else 
+        {
+            std::memcpy(static_cast<void*>(data() + size_), &value, sizeof(T));
+        }
+        ++size_;
+    }
+
+    void pop_back() 
+    {
+        --size_;
+    }
+
+    // Keeps the order of the remaining elements
+    void erase(std::size_t index) 
+    {
+        T* items = data();
+        std::memmove(static_cast<void*>(items + index), items + index + 1, (size_ - index - 1) * sizeof(T));
+        --size_;
+    }
+
+    void clear() 
+    {
+        size_ = 0;
+    }
+
+    // Only ever shrinks
+    void truncate(std::size_t count) 
+    {
+        size_ = std::min(size_, count);
+    }
+
+    void reserve(std::size_t wanted) 
+    {
+        if (wanted <= capacity_) 
+        {
+            return;
+        }
+        T* grown = static_cast<T*>(::operator new(wanted * sizeof(T), std::align_val_t{alignof(T)}));
+        std::memcpy(static_cast<void*>(grown), data(), size_ * sizeof(T));
+        release();
+        heap_ = grown;
+        capacity_ = wanted;
+    }
+
+private:
+
+    void release() 
+    {
+        if (heap_) 
+        {
+            ::operator delete(heap_, std::align_val_t{alignof(T)});
+            heap_ = nullptr;
+            capacity_ = Inline;
+        }
+    }
+
+    void take(SmallVector& other) 
+    {
+        if (other.heap_) 
+        {
+            heap_ = other.heap_;
+            capacity_ = other.capacity_;
+            other.heap_ = nullptr;
+            other.capacity_ = Inline;
+        }
+        else 
+        {
+            std::memcpy(static_cast<void*>(inline_), other.inline_, other.size_ * sizeof(T));
+        }
+        size_ = other.size_;
+        other.size_ = 0;
+    }
+
+    T* heap_ = nullptr;
+    std::size_t size_ = 0;
+    std::size_t capacity_ = Inline;
+    alignas(T) std::byte inline_[Inline * sizeof(T)];
+};
+
+// Identifies a modifier applied to a PointStat. The generation changes every
+// time a slot is reused, so a handle to a removed modifier never matches again.
+// Generation 0 is never handed out, which makes a default handle empty.
+struct ModifierHandle {
+    uint32_t index = 0;
+    uint32_t generation = 0;
+
+    explicit operator bool() const { return generation != 0; }
+    bool operator==(const ModifierHandle&) const = default;
+};
+
+// The slots behind ModifierHandles, shared by PointStat and StatBlock.
+// A slot remembers the position of its modifier in the owner's list, the owner updates
+// it whenever the modifier moves. While a slot is free, position holds the next free slot.
+template<std::size_t Inline>
+class ModifierSlots {
+public:
+
+    static constexpr uint32_t NoSlot = UINT32_MAX;
+
+    ModifierHandle acquire(uint32_t position) 
+    {
+        if (free_ != NoSlot) {
+            uint32_t index = free_;
+            free_ = slots_[index].position;
+            slots_[index].position = position;
+            return ModifierHandle{index, slots_[index].generation};
+        }
+        slots_.push_back(Slot{position, 1});
+        return ModifierHandle{static_cast<uint32_t>(slots_.size() - 1), 1};
+    }
+
+    // Bumping the generation is what makes every handle to the slot stale
+    void release(uint32_t index) 
+    {
+        auto& slot = slots_[index];
+        if (++slot.generation == 0) {
+            slot.generation = 1;
+        }
+        slot.position = free_;
+        free_ = index;
+    }
+
+    bool contains(ModifierHandle handle) const 
+    {
+        return handle.index < slots_.size() and slots_[handle.index].generation == handle.generation;
+    }
+
+    ModifierHandle handle(uint32_t index) const 
+    {
+        return ModifierHandle{index, slots_[index].generation};
+    }
+
+    uint32_t position(uint32_t index) const 
+    {
+        return slots_[index].position;
+    }
+
+    void move(uint32_t index, uint32_t position) 
+    {
+        slots_[index].position = position;
+    }
+
+private:
+
+    struct Slot 
+    {
+        uint32_t position;
+        uint32_t generation;
+    };
+
+    SmallVector<Slot, Inline> slots_;
+    uint32_t free_ = NoSlot;
+};
+
+// Finds the instance a modifier source already has on a stat, by hash, so reapplying a
+// sourced modifier costs the same however many sourced modifiers the stat carries.
+// Open addressing with linear probing; deletes shift the following keys back instead of
+// leaving tombstones, so a long lived stat doesn't slowly fill up with them.
+// Key 0 marks an empty bucket, which is fine because source 0 never gets an entry.
+class ModifierSourceIndex {
+public:
+
+    static constexpr uint32_t NotFound = UINT32_MAX;
+
+    uint32_t find(uint64_t key) const 
+    {
+        if (size_ == 0) {
+            return NotFound;
+        }
+        for (std::size_t i = bucketOf(key);; i = (i + 1) & mask()) {
+            if (buckets_[i].key == key) {
+                return buckets_[i].slot;
+            }
+            if (buckets_[i].key == 0) {
+                return NotFound;
+            }
+        }
+    }
+
+    void insert(uint64_t key, uint32_t slot) 
+    {
+        // Kept at most half full so probes stay short
+        if ((size_ + 1) * 2 > buckets_.size()) {
+            grow();
+        }
+        std::size_t i = bucketOf(key);
+        while (buckets_[i].key != 0 and buckets_[i].key != key) {
+            i = (i + 1) & mask();
+        }
+        size_ += buckets_[i].key == 0;
+        buckets_[i] = Bucket{key, slot};
+    }
+
+    bool erase(uint64_t key) 
+    {
+        if (size_ == 0) {
+            return false;
+        }
+        std::size_t hole = bucketOf(key);
+        while (buckets_[hole].key != key) {
+            if (buckets_[hole].key == 0) {
+                return false;
+            }
+            hole = (hole + 1) & mask();
+        }
+
+        // Anything further along the run whose home isn't between the hole and
+        // where it sits would become unreachable, so it moves back into the hole
+        for (std::size_t i = (hole + 1) & mask(); buckets_[i].key != 0; i = (i + 1) & mask()) {
+            const std::size_t home = bucketOf(buckets_[i].key);
+            if (((i - home) & mask()) >= ((i - hole) & mask())) {
+                buckets_[hole] = buckets_[i];
+                hole = i;
+            }
+        }
+        buckets_[hole] = Bucket{};
+        --size_;
+        return true;
+    }
+
+    void clear() 
+    {
+        std::fill(buckets_.begin(), buckets_.end(), Bucket{});
+        size_ = 0;
+    }
+
+    std::size_t size() const 
+    {
+        return size_;
+    }
+
+private:
+
+    struct Bucket 
+    {
+        uint64_t key = 0;
+        uint32_t slot = 0;
+    };
+
+    std::size_t mask() const 
+    {
+        return buckets_.size() - 1;
+    }
+
+    std::size_t bucketOf(uint64_t key) const 
+    {
+        // Sources are often small sequential ids, mix them before masking
+        key ^= key >> 33;
+        key *= 0xff51afd7ed558ccdull;
+        key ^= key >> 33;
+        return static_cast<std::size_t>(key) & mask();
+    }
+
+    void grow() 
+    {
+        std::vector<Bucket> old = std::move(buckets_);
+        buckets_.assign(std::max<std::size_t>(8, old.size() * 2), Bucket{});
+        size_ = 0;
+        for (const auto& bucket : old) {
+            if (bucket.key != 0) {
+                insert(bucket.key, bucket.slot);
+            }
+        }
+    }
+
+    std::vector<Bucket> buckets_;
+    std::size_t size_ = 0;
+};
+
+// How a PointStat combines its modifiers into max.
+// Sequential applies them one after another in the order they were added.
+// Aggregate keeps running totals per ModifierLayer and evaluates the layers in
+// a fixed order, min((base + adds - subtracts) * multipliers / divisors, caps),
+// so insertion order doesn't matter and adding or removing one is O(1).
+enum class StackingMode : uint8_t {
+    Sequential,
+    Aggregate
+};
+
+// The fixed order aggregate mode evaluates modifiers in, starting from
+// the stat's base max: flat, then percentages, then multipliers, then caps.
+enum class ModifierLayer : uint8_t {
+    Flat,
+    Percent,
+    Multiplicative,
+    Cap,
+    Count
+};
+
+// What happens when a modifier from a source that's already on the stat is applied again.
+// Unique ignores it, Refresh keeps one instance and takes the new value,
+// Stack adds up to the modifier's max stacks then refreshes, Strongest keeps the larger value
+// of two modifiers of the same type (a different type just replaces it, see decideStack).
+enum class StackPolicy : uint8_t {
+    Unique,
+    Refresh,
+    Stack,
+    Strongest
+};
+
+// Tells the caller what addModifier did, mostly so timers know whether to refresh
+enum class StackOutcome : uint8_t {
+    Added,
+    Stacked,
+    Refreshed,
+    Replaced,
+    Rejected
+};
+
 // Base modifier class
 // We constrain everything to positive numbers 
 // to build in safety rather than throw exceptions
 template<PositiveNumber NumberType>
 class Modifier {
 public:
-    enum class Type {
+    enum class Type : uint8_t {
         Multiply,
         Divide,
         Add,
-        Subtract
+        Subtract,
+        Cap,
+        AddPercent,         // value is in basis points, 1500 is +15%
+        SubtractPercent     // value is in basis points, capped at 10000
     };
 
     // Lets build in some 0 value checks into the class,
@@ -82,207 +674,1326 @@ public:
                     break;
                 }
 
-                case Type::Add:
-                {
-                    // zero is actually ok here, and we don't want to ruin a person's
-                    // design on some sort of system by changing it so we will allow
-                    // I would recommend logging here as well.
-                    break;
-                }
+                case Type::Add:
+                {
+                    // zero is actually ok here, and we don't want to ruin a person's
+                    // design on some sort of system by changing it so we will allow
+                    // I would recommend logging here as well.
+                    break;
+                }
+
+                case Type::Subtract:
+                {
+                    // another place you probably want to log. 
+                    break;
+                }
+
+                case Type::Cap:
+                {
+                    // A cap of 0 would break our safety, so it means no cap at all
+                    value_ = std::numeric_limits<NumberType>::max();
+                    break;
+                }
+
+                case Type::AddPercent:
+                case Type::SubtractPercent:
+                {
+                    // 0% is harmless, same as adding 0
+                    break;
+                }
+
+                default:
+                {
+                    // log::error("Type safety broken for Modifier");
+                    break;
+                }
+            }
+        }
+
+        // Taking away more than 100% can only ever mean 100%
+        if (type_ == Type::SubtractPercent and value_ > StatMath::BasisPointsOne) 
+        {
+            value_ = static_cast<NumberType>(StatMath::BasisPointsOne);
+        }
+    }
+
+    ~Modifier() = default;
+
+    Type getType() const { return type_; }
+    NumberType getValue() const { return value_; }
+    // Builds a modifier after letting Policy look at the value, so a Throw build throws on
+    // a 0 multiplier rather than having the constructor quietly turn it into 1
+    template<class Policy>
+    static Modifier make(Type type, NumberType value, bool p_scale = true) 
+    {
+        if constexpr (Policy::Checked) {
+            const bool zero_invalid = type == Type::Multiply or type == Type::Divide or type == Type::Cap;
+            const bool too_large = type == Type::SubtractPercent and value > StatMath::BasisPointsOne;
+            if ((zero_invalid and value == 0) or too_large) [[unlikely]] {
+                Policy::invalidModifier();
+            }
+        }
+        return Modifier(type, value, p_scale);
+    }
+
+    bool getProportionalScaling() const { return proportional_scaling_; }
+    uint32_t getSource() const { return source_; }
+    StackPolicy getStackPolicy() const { return stack_policy_; }
+    uint8_t getMaxStacks() const { return max_stacks_; }
+
+    // Ties the modifier to a source (a potion, an ability, an item...) so applying it again
+    // follows the stacking policy instead of adding another copy. Source 0 means no source.
+    Modifier& setSource(uint32_t source, StackPolicy policy = StackPolicy::Refresh, uint8_t max_stacks = 1) 
+    {
+        source_ = source;
+        stack_policy_ = policy;
+        max_stacks_ = max_stacks > 0 ? max_stacks : 1;
+        return *this;
+    }
+
+    bool operator==(const Modifier&) const = default;
+
+    ModifierLayer getLayer() const 
+    {
+        switch (type_) 
+        {
+            case Type::Multiply:
+            case Type::Divide: return ModifierLayer::Multiplicative;
+            case Type::Cap: return ModifierLayer::Cap;
+            case Type::AddPercent:
+            case Type::SubtractPercent: return ModifierLayer::Percent;
+            default: return ModifierLayer::Flat;
+        }
+    }
+
+private:
+    Type type_;
+    NumberType value_;
+    bool proportional_scaling_;
+    StackPolicy stack_policy_ = StackPolicy::Refresh;
+    uint8_t max_stacks_ = 1;
+    uint32_t source_ = 0;
+};
+
+// Names an interned modifier definition, see ModifierDefs
+enum class ModifierDefId : uint32_t {};
+
+// Flyweight store for modifier definitions. The same "+200 hp ring" is interned once and
+// every stat wearing it only keeps the id, so a million equipped items are a few thousand
+// definitions plus 4 byte references, and recalculating reads definitions that stay in cache.
+// Definitions are immutable and live for the whole program, so intern things with a fixed
+// set of values (items, buffs, talents), not something that changes with every hit.
+// Interning takes a lock, get doesn't, so load definitions up front and equip by id.
+// One off values should go to PointStat::addModifier by value, which never interns.
+template<PositiveNumber NumberType>
+class ModifierDefs {
+public:
+
+    // Returns the id of an equal definition if there is one, otherwise stores it
+    static ModifierDefId intern(const Modifier<NumberType>& modifier) 
+    {
+        const Key key = keyOf(modifier);
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (auto found = index_.find(key); found != index_.end()) {
+            return found->second;
+        }
+
+        const uint32_t id = count_.load(std::memory_order_relaxed);
+        if (id >= ChunkCount * ChunkSize) [[unlikely]] {
+            throw std::length_error("Too many modifier definitions");
+        }
+        Chunk* chunk = chunks_[id >> ChunkBits].load(std::memory_order_relaxed);
+        if (chunk == nullptr) {
+            owned_.push_back(std::make_unique<Chunk>());
+            chunk = owned_.back().get();
+            chunks_[id >> ChunkBits].store(chunk, std::memory_order_release);
+        }
+        std::memcpy(static_cast<void*>(chunk->definitions + (id & ChunkMask)), &modifier, sizeof(modifier));
+        count_.store(id + 1, std::memory_order_release);
+        index_.emplace(key, ModifierDefId{id});
+        return ModifierDefId{id};
+    }
+
+    // Definitions never move, so the reference is good for the life of the program
+    static const Modifier<NumberType>& get(ModifierDefId id) 
+    {
+        const uint32_t index = static_cast<uint32_t>(id);
+        const Chunk* chunk = chunks_[index >> ChunkBits].load(std::memory_order_acquire);
+        return *std::launder(reinterpret_cast<const Modifier<NumberType>*>(chunk->definitions + (index & ChunkMask)));
+    }
+
+    static std::size_t size() 
+    {
+        return count_.load(std::memory_order_acquire);
+    }
+
+private:
+
+    static_assert(std::is_trivially_copyable_v<Modifier<NumberType>>, "Modifier definitions are copied as plain memory");
+
+    static constexpr uint32_t ChunkBits = 10;
+    static constexpr uint32_t ChunkSize = 1u << ChunkBits;
+    static constexpr uint32_t ChunkMask = ChunkSize - 1;
+    static constexpr uint32_t ChunkCount = 4096;
+
+    // Storage grows a chunk at a time so nothing already handed out ever moves
+    struct Chunk 
+    {
+        alignas(Modifier<NumberType>) unsigned char definitions[ChunkSize][sizeof(Modifier<NumberType>)];
+    };
+
+    // Everything that makes two modifiers the same, packed without padding bytes
+    struct Key 
+    {
+        uint64_t value;
+        uint32_t source;
+        uint8_t type;
+        uint8_t policy;
+        uint8_t max_stacks;
+        uint8_t proportional;
+
+        bool operator==(const Key&) const = default;
+    };
+
+    struct KeyHash 
+    {
+        std::size_t operator()(const Key& key) const 
+        {
+            uint64_t hash = key.value * 0x9e3779b97f4a7c15ull;
+            hash ^= (static_cast<uint64_t>(key.source) << 32) | (static_cast<uint64_t>(key.type) << 24)
+                | (static_cast<uint64_t>(key.policy) << 16) | (static_cast<uint64_t>(key.max_stacks) << 8) | key.proportional;
+            hash ^= hash >> 29;
+            return static_cast<std::size_t>(hash * 0xbf58476d1ce4e5b9ull);
+        }
+    };
+
+    static Key keyOf(const Modifier<NumberType>& modifier) 
+    {
+        return Key{modifier.getValue(), modifier.getSource(), static_cast<uint8_t>(modifier.getType()),
+            static_cast<uint8_t>(modifier.getStackPolicy()), modifier.getMaxStacks(), modifier.getProportionalScaling()};
+    }
+
+    inline static std::mutex mutex_;
+    inline static std::unordered_map<Key, ModifierDefId, KeyHash> index_;
+    inline static std::vector<std::unique_ptr<Chunk>> owned_;
+    inline static std::array<std::atomic<Chunk*>, ChunkCount> chunks_{};
+    inline static std::atomic<uint32_t> count_{0};
+};
+
+// Modifiers a stat was handed by value. Entries keep a ModifierDefId either way, a local one
+// has the top bit set and indexes in here, so a one off value never goes near ModifierDefs.
+// Each local remembers the slot of the entry using it, because freeing one moves the last
+// local into the gap and its entry has to be told the new id (that's what relink is for).
+template<PositiveNumber NumberType>
+class LocalModifiers {
+public:
+
+    // ModifierDefs never gets near this many definitions, so the top bit is free
+    static constexpr uint32_t LocalDef = 0x80000000u;
+
+    // Stands in for a definition when the modifier should be kept here instead
+    static constexpr ModifierDefId NotInterned{UINT32_MAX};
+
+    static bool isLocal(ModifierDefId def)
+    {
+        return static_cast<uint32_t>(def) & LocalDef;
+    }
+
+    const Modifier<NumberType>& get(ModifierDefId def) const
+    {
+        if (isLocal(def)) {
+            return locals_[static_cast<uint32_t>(def) & ~LocalDef].modifier;
+        }
+        return ModifierDefs<NumberType>::get(def);
+    }
+
+    // Points def at interned, or at a copy of modifier when interned is NotInterned.
+    // owner is the slot of the entry def belongs to.
+    template<class Relink>
+    void store(ModifierDefId& def, uint32_t owner, const Modifier<NumberType>& modifier, ModifierDefId interned, Relink&& relink)
+    {
+        if (interned != NotInterned) {
+            release(def, relink);
+            def = interned;
+        }
+        else if (isLocal(def)) {
+            locals_[static_cast<uint32_t>(def) & ~LocalDef].modifier = modifier;
+        }
+        else {
+            def = ModifierDefId{LocalDef | static_cast<uint32_t>(locals_.size())};
+            locals_.push_back(Local{modifier, owner});
+        }
+    }
+
+    // Frees def's copy if it has one, relink(slot, id) hands the moved local's entry its new id
+    template<class Relink>
+    void release(ModifierDefId def, Relink&& relink)
+    {
+        if (not isLocal(def)) {
+            return;
+        }
+        const uint32_t index = static_cast<uint32_t>(def) & ~LocalDef;
+        if (index + 1 != locals_.size()) {
+            locals_[index] = locals_.back();
+            relink(locals_[index].owner, def);
+        }
+        locals_.pop_back();
+    }
+
+    void clear()
+    {
+        locals_.clear();
+    }
+
+private:
+
+    struct Local
+    {
+        Modifier<NumberType> modifier;
+        uint32_t owner;
+    };
+
+    SmallVector<Local, 2> locals_;
+};
+
+// Running totals for aggregate stacking, the same in PointStat and StatBlock.
+// Sums and products that overflow saturate and can't be undone by subtraction or division,
+// and removing the lowest cap needs a rescan of the remaining caps, apply says when that
+// happened and the owner has to rebuild the totals from its entries.
+template<PositiveNumber NumberType>
+struct AggregateTotals
+{
+    uint64_t added = 0;
+    uint64_t subtracted = 0;
+    uint64_t percent_added = 0;
+    uint64_t percent_subtracted = 0;
+    uint64_t multiplier = 1;
+    uint64_t divisor = 1;
+    NumberType cap = std::numeric_limits<NumberType>::max();
+    bool saturated = false;
+
+    // Returns true if the totals need a rebuild
+    bool apply(const Modifier<NumberType>& modifier, bool adding)
+    {
+        const uint64_t value = modifier.getValue();
+        bool rebuild = false;
+        switch (modifier.getType())
+        {
+            case Modifier<NumberType>::Type::Add:
+            {
+                added = adding ? sum(added, value) : added - value;
+                break;
+            }
+
+            case Modifier<NumberType>::Type::Subtract:
+            {
+                subtracted = adding ? sum(subtracted, value) : subtracted - value;
+                break;
+            }
+
+            case Modifier<NumberType>::Type::Multiply:
+            {
+                multiplier = adding ? StatMath::saturatingMultiply(multiplier, value) : multiplier / value;
+                saturated = saturated or multiplier == UINT64_MAX;
+                break;
+            }
+
+            case Modifier<NumberType>::Type::Divide:
+            {
+                divisor = adding ? StatMath::saturatingMultiply(divisor, value) : divisor / value;
+                saturated = saturated or divisor == UINT64_MAX;
+                break;
+            }
+
+            case Modifier<NumberType>::Type::AddPercent:
+            {
+                percent_added = adding ? sum(percent_added, value) : percent_added - value;
+                break;
+            }
+
+            case Modifier<NumberType>::Type::SubtractPercent:
+            {
+                percent_subtracted = adding ? sum(percent_subtracted, value) : percent_subtracted - value;
+                break;
+            }
+
+            case Modifier<NumberType>::Type::Cap:
+            {
+                if (adding) {
+                    cap = std::min<NumberType>(cap, modifier.getValue());
+                }
+                else if (modifier.getValue() == cap) {
+                    rebuild = true;
+                }
+                break;
+            }
+        }
+
+        // A saturated sum or product can't be taken back out
+        return rebuild or (not adding and saturated);
+    }
+
+    // What one layer makes of the value the layer before it produced
+    uint64_t layer(ModifierLayer layer, uint64_t input) const
+    {
+        switch (layer)
+        {
+            case ModifierLayer::Flat:
+            {
+                uint64_t flat = StatMath::saturatingAdd(input, added);
+                return flat > subtracted ? flat - subtracted : 0;
+            }
+
+            case ModifierLayer::Percent:
+            {
+                // Percentages in the same layer add up rather than compound
+                uint64_t factor = StatMath::saturatingAdd(StatMath::BasisPointsOne, percent_added);
+                factor = factor > percent_subtracted ? factor - percent_subtracted : 0;
+                return StatMath::multiplyDivide(input, factor, StatMath::BasisPointsOne);
+            }
+
+            case ModifierLayer::Multiplicative: return StatMath::multiplyDivide(input, multiplier, divisor);
+            case ModifierLayer::Cap: return std::min<uint64_t>(input, cap);
+            default: return input;
+        }
+    }
+
+    // Every layer in order, starting from the base max
+    NumberType evaluate(uint64_t base) const
+    {
+        for (std::size_t index = 0; index < static_cast<std::size_t>(ModifierLayer::Count); ++index) {
+            base = layer(static_cast<ModifierLayer>(index), base);
+        }
+        return clamp(base);
+    }
+
+    // Aggregate max is always kept in [1, numeric max]
+    static NumberType clamp(uint64_t value)
+    {
+        constexpr uint64_t limit = std::numeric_limits<NumberType>::max();
+        return static_cast<NumberType>(std::clamp<uint64_t>(value, 1, limit));
+    }
+
+    // Sums saturate too, and flag it the same way the products do
+    uint64_t sum(uint64_t total, uint64_t value)
+    {
+        const uint64_t result = StatMath::saturatingAdd(total, value);
+        saturated = saturated or result == UINT64_MAX;
+        return result;
+    }
+};
+
+// What reapplying a modifier from a source that already has an instance does to that instance.
+// replace means it takes the incoming modifier's value, stacks is its stack count afterwards.
+struct StackDecision
+{
+    StackOutcome outcome;
+    bool replace;
+    uint8_t stacks;
+};
+
+// same_definition is for callers that can tell two modifiers are equal without comparing them
+template<PositiveNumber NumberType>
+StackDecision decideStack(const Modifier<NumberType>& existing, uint8_t stacks, const Modifier<NumberType>& incoming, bool same_definition = false)
+{
+    switch (incoming.getStackPolicy())
+    {
+        case StackPolicy::Unique: return StackDecision{StackOutcome::Rejected, false, stacks};
+        case StackPolicy::Refresh: return StackDecision{StackOutcome::Refreshed, not same_definition and not (incoming == existing), stacks};
+
+        case StackPolicy::Stack:
+        {
+            if (stacks >= incoming.getMaxStacks()) {
+                return StackDecision{StackOutcome::Refreshed, false, stacks};
+            }
+            return StackDecision{StackOutcome::Stacked, false, static_cast<uint8_t>(stacks + 1)};
+        }
+
+        case StackPolicy::Strongest:
+        {
+            // Values of different types don't measure the same thing (+500 against +10% against x2),
+            // and which does more depends on the max it lands on, so the newer one simply takes over
+            if (incoming.getType() != existing.getType()) {
+                return StackDecision{StackOutcome::Replaced, true, stacks};
+            }
+            if (incoming.getValue() < existing.getValue()) {
+                return StackDecision{StackOutcome::Rejected, false, stacks};
+            }
+            const bool stronger = incoming.getValue() > existing.getValue();
+            return StackDecision{stronger ? StackOutcome::Replaced : StackOutcome::Refreshed, stronger, stacks};
+        }
+    }
+    return StackDecision{StackOutcome::Rejected, false, stacks};
+}
+
+// The ratio a transaction scales current by. Every run of proportional changes contributes
+// max at its end over max at its start, kept as an exact fraction in lowest terms, so
+// applying it rounds once however many changes went in.
+struct PendingScale
+{
+    uint64_t num = 1;
+    uint64_t den = 1;
+
+    template<PositiveNumber NumberType>
+    void accumulate(uint64_t from, uint64_t to, NumberType& current)
+    {
+        const uint64_t common = std::gcd(from, to);
+        from /= common;
+        to /= common;
+        if (from == to) {
+            return;
+        }
+
+        const uint64_t num_common = std::gcd(to, den);
+        const uint64_t den_common = std::gcd(from, num);
+        const uint64_t reduced_num = num / den_common;
+        const uint64_t reduced_den = den / num_common;
+        to /= num_common;
+        from /= den_common;
+        if (reduced_num <= UINT64_MAX / to and reduced_den <= UINT64_MAX / from) [[likely]] {
+            num = reduced_num * to;
+            den = reduced_den * from;
+            return;
+        }
+
+        // Too big to carry exactly, round what's pending into current and start a new ratio
+        apply(current);
+        num = to * num_common;
+        den = from * den_common;
+    }
+
+    // Scaling never takes a non zero current to 0
+    template<PositiveNumber NumberType>
+    void apply(NumberType& current)
+    {
+        if (num != den and current > 0) {
+            constexpr uint64_t limit = std::numeric_limits<NumberType>::max();
+            const uint64_t scaled = StatMath::multiplyDivide(current, num, den);
+            current = static_cast<NumberType>(std::clamp<uint64_t>(scaled, 1, limit));
+        }
+        num = 1;
+        den = 1;
+    }
+};
+
+// The tick count lazy regeneration is measured against.
+// The game loop advances it once per tick and stats catch up whenever they're touched,
+// so a stat sitting at full (or with no regen at all) costs nothing per tick.
+class PointStatClock {
+public:
+
+    static uint64_t now() 
+    {
+        return ticks_.load(std::memory_order_relaxed);
+    }
+
+    static void advance(uint64_t ticks = 1) 
+    {
+        ticks_.fetch_add(ticks, std::memory_order_relaxed);
+    }
+
+    // Only ever move it forward, stats treat a clock that went back as no time passing
+    static void set(uint64_t ticks) 
+    {
+        ticks_.store(ticks, std::memory_order_relaxed);
+    }
+
+private:
+    inline static std::atomic<uint64_t> ticks_{0};
+};
+
+// One threshold crossing, rising means current went from below the level to at or above it
+template<PositiveNumber NumberType, class Policy = OverflowPolicy::Clamp>
+struct ThresholdEvent 
+{
+    PointStat<NumberType, Policy>* stat;
+    uint32_t id;
+    bool rising;
+    NumberType current;
+    NumberType max;
+};
+
+// Collects threshold crossings from any number of stats until the owner dispatches them,
+// typically once per tick. Handlers are registered per threshold id.
+template<PositiveNumber NumberType, class Policy = OverflowPolicy::Clamp>
+class ThresholdEvents {
+public:
+
+    using Event = ThresholdEvent<NumberType, Policy>;
+    using Handler = std::function<void(const Event&)>;
+
+    void on(uint32_t id, Handler handler) 
+    {
+        handlers_.emplace_back(id, std::move(handler));
+    }
+
+    void push(const Event& event) 
+    {
+        events_.push_back(event);
+    }
+
+    std::span<const Event> events() const 
+    {
+        return events_;
+    }
+
+    // Runs the handlers for everything that happened since the last dispatch, in order.
+    // Handlers may touch stats, anything that crosses because of that goes to the next batch.
+    std::size_t dispatch() 
+    {
+        batch_.swap(events_);
+        events_.clear();
+        for (const auto& event : batch_) {
+            for (const auto& [id, handler] : handlers_) {
+                if (id == event.id) {
+                    handler(event);
+                }
+            }
+        }
+        std::size_t dispatched = batch_.size();
+        batch_.clear();
+        return dispatched;
+    }
+
+private:
+    std::vector<std::pair<uint32_t, Handler>> handlers_;
+    std::vector<Event> events_;
+    std::vector<Event> batch_;
+};
+
+// Policy is one of the OverflowPolicy structs (or anything shaped like them)
+template<PositiveNumber NumberType, class Policy>
+class PointStat {
+public:
+
+    using RegenType = std::make_signed_t<NumberType>;
+
+    PointStat(NumberType initial, NumberType max, StackingMode mode = StackingMode::Sequential)
+        : current_(initial)
+        , max_(max)
+        , base_max_(max)
+        , mode_(mode)
+        , regen_tick_(PointStatClock::now())
+    {
+        // Again we are choosing to build in type safety to avoid paying costs
+        // on checking if our values are safe to use everytime we want to use them.
+        // Only modifier range checks depend on the policy, everything downstream divides by max
+        // (rescaling, transaction ratios) so a 0 can't get in even with the checks compiled out.
+        if (max <= 0) 
+        {
+            Policy::invalidMax();
+            max_ = base_max_ = 1;
+        }
+        // Here you might rather just throw or set the max to initial
+        if (initial > max_) {
+           // log::invalid_argument("PointStat initial value set higher than max value during construction");
+            current_ = max_;
+        }
+    }
+
+    // Modifiers are kept by value, the first InlineModifiers of them inside the stat
+    static constexpr std::size_t InlineModifiers = 4;
+
+    // Add a modifier, the returned handle is what removeModifier takes.
+    // In sequential mode a modifier that can't be applied isn't stored and the handle is empty,
+    // in aggregate mode it is always stored and max is clamped to the valid range instead.
+    // A modifier with a source that's already here follows its StackPolicy and
+    // the handle of the existing instance comes back.
+    // A modifier passed by value is kept in the stat itself and never goes near ModifierDefs,
+    // that's the way in for one off values (formula results, commands, timed buffs).
+    ModifierHandle addModifier(const Modifier<NumberType>& modifier) 
+    {
+        StackOutcome outcome;
+        return addModifier(modifier, outcome);
+    }
+
+    ModifierHandle addModifier(const Modifier<NumberType>& modifier, StackOutcome& outcome) 
+    {
+        ModifierHandle handle = insertModifier(modifier, NotInterned, outcome);
+        notifyThresholds();
+        return handle;
+    }
+
+    // For definitions shared by many stats, interned up front, the stat only keeps the id
+    ModifierHandle addModifier(ModifierDefId def) 
+    {
+        StackOutcome outcome;
+        return addModifier(def, outcome);
+    }
+
+    ModifierHandle addModifier(ModifierDefId def, StackOutcome& outcome) 
+    {
+        ModifierHandle handle = insertModifier(ModifierDefs<NumberType>::get(def), def, outcome);
+        notifyThresholds();
+        return handle;
+    }
+
+    ModifierHandle addModifier(std::unique_ptr<Modifier<NumberType>> modifier) 
+    {
+        return addModifier(*modifier);
+    }
+
+    // Remove a modifier, stale or empty handles are simply ignored
+    bool removeModifier(ModifierHandle handle) 
+    {
+        bool removed = eraseModifier(handle);
+        notifyThresholds();
+        return removed;
+    }
+
+    // Gives an applied modifier a new value where it sits, everything else about it stays.
+    // In sequential mode it keeps its place in the order, which removing it and adding it
+    // again wouldn't. Returns false for stale or empty handles.
+    bool updateModifier(ModifierHandle handle, NumberType value)
+    {
+        if (not hasModifier(handle)) {
+            return false;
+        }
+        regenerate();
+        auto& entry = modifiers_[slots_.position(handle.index)];
+        const Modifier<NumberType>& old = modifierOf(entry);
+        Modifier<NumberType> updated(old.getType(), value, old.getProportionalScaling());
+        updated.setSource(old.getSource(), old.getStackPolicy(), old.getMaxStacks());
+        if (not (updated == old)) {
+            changeEntry(entry, entry.stacks, &updated, NotInterned);
+            notifyThresholds();
+        }
+        return true;
+    }
+
+    // Removes a batch of modifiers inside one transaction, so max is recalculated once and
+    // current ends up where removing them one at a time would leave it, rounded once.
+    // Stale handles are skipped, returns how many were actually removed.
+    std::size_t removeModifiers(std::span<const ModifierHandle> handles) 
+    {
+        beginModify();
+        std::size_t removed = 0;
+        bool holes = false;
+        for (const auto handle : handles) {
+            if (not hasModifier(handle)) {
+                continue;
+            }
+
+            uint32_t position = slots_.position(handle.index);
+            const auto& entry = modifiers_[position];
+            beforeChange(modifierOf(entry).getProportionalScaling());
+            if (mode_ == StackingMode::Aggregate) {
+                aggregateEntry(entry, false);
+                swapEraseEntry(position);
+                max_ = aggregateMax();
+            }
+            else {
+                // Leave a hole for now, we close them all in one pass below
+                releaseEntry(entry);
+                modifiers_[position].slot = NoSlot;
+                modify_.stale = true;
+                holes = true;
+            }
+            ++removed;
+        }
+
+        if (holes) {
+            compactEntries();
+        }
+        commit();
+        return removed;
+    }
+
+    // Groups modifier changes (a whole loadout going on or off) so that max is rebuilt
+    // at most once and current is rescaled once, instead of drifting a little with every
+    // modifier. Only the proportional changes scale current, their combined ratio is kept
+    // as an exact fraction and applied at commit, so the result is what applying them one
+    // at a time gives with a single rounding. Transactions nest, only the outermost commit
+    // does the work. max(), current() and thresholds aren't up to date until then.
+    void beginModify() 
+    {
+        if (modify_.depth++ == 0) {
+            regenerate();
+            modify_.stale = false;
+            modify_.in_run = false;
+            modify_.scale = PendingScale{};
+        }
+    }
+
+    void commit() 
+    {
+        if (modify_.depth == 0 or --modify_.depth > 0) {
+            return;
+        }
+        if (modify_.in_run) {
+            modify_.in_run = false;
+            modify_.scale.accumulate(modify_.run_from, settledMax(), current_);
+        }
+        settledMax();
+        modify_.scale.apply(current_);
+        if (current_ > max_) {
+            current_ = max_;
+        }
+        notifyThresholds();
+    }
+
+    // addModifier for each definition inside one transaction. handles, if given,
+    // gets what addModifier returned for each. Returns how many were applied.
+    std::size_t applyModifiers(std::span<const ModifierDefId> defs, std::span<ModifierHandle> handles = {}) 
+    {
+        beginModify();
+        std::size_t applied = 0;
+        for (std::size_t i = 0; i < defs.size(); ++i) {
+            ModifierHandle handle = addModifier(defs[i]);
+            applied += static_cast<bool>(handle);
+            if (i < handles.size()) {
+                handles[i] = handle;
+            }
+        }
+        commit();
+        return applied;
+    }
+
+    std::size_t applyModifiers(std::span<const Modifier<NumberType>> modifiers, std::span<ModifierHandle> handles = {}) 
+    {
+        beginModify();
+        std::size_t applied = 0;
+        for (std::size_t i = 0; i < modifiers.size(); ++i) {
+            ModifierHandle handle = addModifier(modifiers[i]);
+            applied += static_cast<bool>(handle);
+            if (i < handles.size()) {
+                handles[i] = handle;
+            }
+        }
+        commit();
+        return applied;
+    }
+
+    bool hasModifier(ModifierHandle handle) const 
+    {
+        return slots_.contains(handle);
+    }
+
+    // The instance currently applied for a source, empty if there is none
+    ModifierHandle findModifier(uint32_t source) const 
+    {
+        uint32_t slot = source != 0 ? findSource(source) : NoSlot;
+        return slot != NoSlot ? slots_.handle(slot) : ModifierHandle{};
+    }
+
+    uint8_t stacks(ModifierHandle handle) const 
+    {
+        return hasModifier(handle) ? modifiers_[slots_.position(handle.index)].stacks : 0;
+    }
+
+    // Somewhere for a ModifierTimerWheel to remember which timer expires this modifier
+    uint32_t timer(ModifierHandle handle) const 
+    {
+        return hasModifier(handle) ? modifiers_[slots_.position(handle.index)].timer : NoTimer;
+    }
+
+    void setTimer(ModifierHandle handle, uint32_t timer) 
+    {
+        if (hasModifier(handle)) {
+            modifiers_[slots_.position(handle.index)].timer = timer;
+        }
+    }
+
+    static constexpr uint32_t NoTimer = UINT32_MAX;
+
+    NumberType current() 
+    {
+        regenerate();
+        return current_;
+    }
+
+    NumberType value() 
+    {
+        regenerate();
+        return current_;
+    }
+
+    NumberType max() 
+    {
+        return max_;
+    }
+
+    NumberType baseMax() 
+    {
+        return base_max_;
+    }
+
+    // Moves the base and puts every modifier back on top of it.
+    // With proportional current keeps its fraction of max, otherwise it's only clamped.
+    void setBaseMax(NumberType base_max, bool proportional = true) 
+    {
+        regenerate();
+        NumberType old_max = beforeChange(proportional);
+        base_max_ = std::max<NumberType>(base_max, 1);
+        if (mode_ == StackingMode::Aggregate) {
+            // Only the first layer reads the base
+            dirty_from_ = 0;
+            max_ = aggregateMax();
+        }
+        else {
+            refreshMax();
+        }
+
+        scaleCurrent(old_max, proportional);
+        if (current_ > max_ and modify_.depth == 0) {
+            current_ = max_;
+        }
+        notifyThresholds();
+    }
+
+    StackingMode mode() const 
+    {
+        return mode_;
+    }
+
+    // Points gained per PointStatClock tick, negative drains instead.
+    // Nothing runs per tick, current catches up whenever the stat is read or changed,
+    // stopping at max (or 0 for a drain).
+    void setRegen(RegenType per_tick) 
+    {
+        regenerate();
+        regen_ = per_tick;
+    }
+
+    RegenType regen() const 
+    {
+        return regen_;
+    }
+
+    bool clearModifiers() 
+    {
+        if (modifiers_.empty()) {
+            return false;
+        }
+        regenerate();
+        
+        // Remember where max was for the proportional scaling below
+        NumberType old_max = beforeChange(true);
+        
+        // Clear all modifiers, releasing the slots makes every handle stale
+        for (const auto& entry : modifiers_) {
+            slots_.release(entry.slot);
+        }
+        modifiers_.clear();
+        sources_.clear();
+        locals_.clear();
+        totals_ = AggregateTotals<NumberType>{};
+        dirty_from_ = 0;
+        
+        // Reset max to base max
+        max_ = base_max_;
+        
+        modify_.stale = false;
+        
+        // Scale current value proportionally, a transaction does it at commit
+        if (modify_.depth == 0) {
+            current_ = current_ < old_max ? StatMath::rescale(current_, max_, old_max) : max_;
+        }
+        
+        notifyThresholds();
+        return true;
+    }
+
+    // Add points with bounds checking
+    bool add(NumberType points) 
+    {
+        regenerate();
+        flushScale();
+        bool added = addPoints(points);
+        notifyThresholds();
+        return added;
+    }
+
+    // Remove points with bounds checking
+    bool remove(NumberType points) 
+    {
+        regenerate();
+        flushScale();
+        bool removed = removePoints(points);
+        notifyThresholds();
+        return removed;
+    }
+
+    // Reports crossings of value into events whenever a change moves current across it,
+    // nothing is polled. With fraction the value is in basis points of max (3000 is 30%)
+    // and follows max around. Rising means current went from below the level to at or above it,
+    // so "at zero" is a falling crossing of 1 and "back to full" a rising one of 10000 with fraction.
+    // Regeneration is lazy, so a crossing from regen shows up when the stat is next read or changed.
+    void addThreshold(ThresholdEvents<NumberType, Policy>& events, uint32_t id, NumberType value, bool fraction = false) 
+    {
+        regenerate();
+        if (not thresholds_.set) {
+            thresholds_.set = std::make_unique<ThresholdSet>();
+        }
+        auto& set = *thresholds_.set;
+        set.entries.push_back(Threshold{&events, id, value, fraction, 0, false});
+        // Start from the current state without firing anything
+        set.entries.back().level = thresholdLevel(set.entries.back());
+        set.entries.back().above = set.entries.back().level <= current_;
+        relevel(set);
+    }
+
+    bool removeThreshold(uint32_t id) 
+    {
+        if (not thresholds_.set) {
+            return false;
+        }
+        auto& entries = thresholds_.set->entries;
+        auto found = std::find_if(entries.begin(), entries.end(), [id](const Threshold& entry) { return entry.id == id; });
+        if (found == entries.end()) {
+            return false;
+        }
+        entries.erase(found);
+        relevel(*thresholds_.set);
+        return true;
+    }
+
+    // Convenience method for chaining modifiers
+    PointStat& modify(const Modifier<NumberType>& modifier) {
+        addModifier(modifier);
+        return *this;
+    }
+
+    PointStat& modify(std::unique_ptr<Modifier<NumberType>> modifier) {
+        addModifier(*modifier);
+        return *this;
+    }
+
+private:
 
-                case Type::Subtract:
-                {
-                    // another place you probably want to log. 
-                    break;
-                }
+    bool addPoints(NumberType points) 
+    {
+        if constexpr (Policy::Branchless) {
+            // The room left can't overflow, and comparing against it covers the overflow case too
+            const bool fits = current_ <= max_ and points <= static_cast<NumberType>(max_ - current_);
+            current_ = fits ? static_cast<NumberType>(current_ + points) : max_;
+            return fits;
+        }
+        else {
+            // Check for potential overflow
+            if (points > std::numeric_limits<NumberType>::max() - current_) {
+                current_ = max_;
+                return false;
+            }
+            
+            // Add points but cap at max
+            NumberType new_value = current_ + points;
+            if (new_value > max_) {
+                current_ = max_;
+                return false;  // Couldn't add all points
+            } else {
+                current_ = new_value;
+                return true;   // Successfully added all points
+            }
+        }
+    }
 
-                default:
-                {
-                    // log::error("Type safety broken for Modifier");
-                    break;
-                }
+    bool removePoints(NumberType points) 
+    {
+        if constexpr (Policy::Branchless) {
+            const bool fits = points <= current_;
+            current_ = fits ? static_cast<NumberType>(current_ - points) : NumberType{0};
+            return fits;
+        }
+        else {
+            if (points > current_) {
+                current_ = 0;
+                return false;  // Couldn't remove all points
+            } else {
+                current_ -= points;
+                return true;   // Successfully removed all points
             }
         }
     }
 
-    ~Modifier() = default;
+    struct Threshold 
+    {
+        ThresholdEvents<NumberType, Policy>* events;
+        uint32_t id;
+        NumberType value;
+        bool fraction;
+        uint64_t level;
+        bool above;
+    };
 
-    Type getType() const { return type_; }
-    NumberType getValue() const { return value_; }
-    bool getProportionalScaling() const { return proportional_scaling_; }
+    // Sorted by level, so the thresholds at or below current are always a prefix and band
+    // is its length. A change in current only walks the band edge, max changing re-levels everything.
+    struct ThresholdSet 
+    {
+        std::vector<Threshold> entries;
+        std::size_t band = 0;
+        NumberType max = 0;
+    };
 
-private:
-    Type type_;
-    NumberType value_;
-    bool proportional_scaling_;
-};
+    // Only allocated for stats that have thresholds, copies get their own
+    struct ThresholdHolder 
+    {
+        ThresholdHolder() = default;
+        ThresholdHolder(ThresholdHolder&&) noexcept = default;
+        ThresholdHolder& operator=(ThresholdHolder&&) noexcept = default;
 
-template<PositiveNumber NumberType>
-class PointStat {
-public:
+        ThresholdHolder(const ThresholdHolder& other) 
+            : set(other.set ? std::make_unique<ThresholdSet>(*other.set) : nullptr)
+        {
+        }
 
-    PointStat(NumberType initial, NumberType max)
-        : current_(initial)
-        , max_(max)
-        , base_max_(max)
-    {
-        // Again we are choosing to build in type safety to avoid paying costs
-        // on checking if our values are safe to use everytime we want to use them.
-        if (max <= 0) 
+        ThresholdHolder& operator=(const ThresholdHolder& other) 
         {
-            throw std::invalid_argument("PointStat max must be positive");
+            set = other.set ? std::make_unique<ThresholdSet>(*other.set) : nullptr;
+            return *this;
         }
-        // Here you might rather just throw or set the max to initial
-        // I can probably add "policies" for such things.. later..
-        if (initial > max) {
-           // log::invalid_argument("PointStat initial value set higher than max value during construction");
-            current_ = max;
+
+        std::unique_ptr<ThresholdSet> set;
+    };
+
+    uint64_t thresholdLevel(const Threshold& entry) const 
+    {
+        return entry.fraction ? StatMath::multiplyDivide(max_, entry.value, StatMath::BasisPointsOne) : entry.value;
+    }
+
+    void crossed(Threshold& entry, bool rising) 
+    {
+        entry.above = rising;
+        entry.events->push(ThresholdEvent<NumberType, Policy>{this, entry.id, rising, current_, max_});
+    }
+
+    void notifyThresholds() 
+    {
+        if (not thresholds_.set or modify_.depth > 0) [[likely]] {
+            return;
+        }
+        auto& set = *thresholds_.set;
+        if (set.max != max_) {
+            relevel(set);
+            return;
+        }
+
+        auto& entries = set.entries;
+        while (set.band < entries.size() and entries[set.band].level <= current_) {
+            crossed(entries[set.band++], true);
+        }
+        while (set.band > 0 and entries[set.band - 1].level > current_) {
+            crossed(entries[--set.band], false);
+        }
+    }
+
+    void relevel(ThresholdSet& set) 
+    {
+        set.max = max_;
+        for (auto& entry : set.entries) {
+            entry.level = thresholdLevel(entry);
+        }
+        std::stable_sort(set.entries.begin(), set.entries.end(), [](const Threshold& a, const Threshold& b) {
+            return a.level < b.level;
+        });
+
+        set.band = 0;
+        for (auto& entry : set.entries) {
+            bool above = entry.level <= current_;
+            if (above != entry.above) {
+                crossed(entry, above);
+            }
+            set.band += above;
         }
     }
 
-    // Add a modifier
-    void addModifier(std::unique_ptr<Modifier<NumberType>> modifier) 
+    // def is NotInterned for a modifier that's stored in the stat
+    ModifierHandle insertModifier(const Modifier<NumberType>& modifier, ModifierDefId def, StackOutcome& outcome) 
     {
-        auto mod_type = modifier->getType();
-        auto start_value = max_;
-        if (NumberType result = applyModifier(*modifier); result > 0) 
+        // Whatever regenerated so far did so under the old max
+        regenerate();
+        if (modifier.getSource() != 0) {
+            if (uint32_t slot = findSource(modifier.getSource()); slot != NoSlot) {
+                return restack(slot, modifier, def, outcome);
+            }
+        }
+
+        // A removal earlier in the transaction may have left max behind,
+        // catch up once so this modifier is judged against the real value
+        settledMax();
+        auto start_value = beforeChange(modifier.getProportionalScaling());
+        NumberType result = 0;
+        if (mode_ == StackingMode::Aggregate) 
+        {
+            aggregate(modifier, true);
+            result = aggregateMax();
+        }
+        else 
+        {
+            result = applyModifier(modifier);
+        }
+
+        if (result > 0) 
         {
             max_ = result;
+            scaleCurrent(start_value, modifier.getProportionalScaling());
             
-            if (modifier->getProportionalScaling())
-            {
-                // Scale current value proportionally
-                double ratio = static_cast<double>(current_) / start_value;
-                current_ = static_cast<NumberType>(ratio * max_);
-                
-                // Ensure current doesn't become zero due to rounding
-                if (current_ == 0 and ratio > 0) {
-                    current_ = 1;
-                }
+            ModifierHandle handle = slots_.acquire(static_cast<uint32_t>(modifiers_.size()));
+            modifiers_.push_back(ModifierEntry{ModifierDefId{}, handle.index, NoTimer, 1});
+            storeModifier(modifiers_.back(), modifier, def);
+            if (modifier.getSource() != 0) {
+                sources_.insert(modifier.getSource(), handle.index);
             }
-            
-            modifiers_.push_back(std::move(modifier));
+            outcome = StackOutcome::Added;
+            return handle;
         }
+        outcome = StackOutcome::Rejected;
+        return ModifierHandle{};
     }
 
-    // Remove a modifier
-    bool removeModifier(const std::unique_ptr<Modifier<NumberType>>& modifier) 
+    bool eraseModifier(ModifierHandle handle) 
     {
-        auto it = std::find_if(modifiers_.begin(), modifiers_.end(), 
-                              [&modifier](const auto& elem) { return elem.get() == modifier.get(); });
-        
-        if (it != modifiers_.end()) {
+        if (hasModifier(handle)) {
+            regenerate();
             // Store original values
-            NumberType old_max = max_;
-            
-            // Remove the modifier
-            modifiers_.erase(it);
-            
-            // Recalculate max from base
-            recalculateMax();
+            uint32_t position = slots_.position(handle.index);
+            bool proportional = modifierOf(modifiers_[position]).getProportionalScaling();
+            NumberType old_max = beforeChange(proportional);
             
-            // Apply proportional scaling if needed
-            if (modifier->getProportionalScaling() && old_max > 0) {
-                // Scale current value proportionally
-                double ratio = static_cast<double>(current_) / old_max;
-                current_ = static_cast<NumberType>(ratio * max_);
+            if (mode_ == StackingMode::Aggregate) {
+                // Order doesn't matter here so the last entry can fill the gap
+                aggregateEntry(modifiers_[position], false);
+                swapEraseEntry(position);
+                max_ = aggregateMax();
+            }
+            else {
+                // Remove the modifier
+                eraseEntry(position);
                 
-                // Ensure current doesn't become zero due to rounding
-                if (current_ == 0 and ratio > 0) {
-                    current_ = 1;
-                }
+                // Recalculate max from base
+                refreshMax();
             }
             
+            // Apply proportional scaling if needed
+            scaleCurrent(old_max, proportional);
+            
             return true;
         }
         return false;
     }
 
-    NumberType current() 
+    // Just the definition id and the runtime state, 16 bytes whatever NumberType is.
+    // A modifier that wasn't interned lives in locals_, see LocalModifiers.
+    struct ModifierEntry 
     {
-        return current_;
+        ModifierDefId def;
+        uint32_t slot;
+        uint32_t timer;
+        uint8_t stacks;
+    };
+
+    static constexpr ModifierDefId NotInterned = LocalModifiers<NumberType>::NotInterned;
+
+    const Modifier<NumberType>& modifierOf(const ModifierEntry& entry) const 
+    {
+        return locals_.get(entry.def);
     }
 
-    NumberType value() 
+    // Points the entry at a definition, or at its own copy of modifier when def is NotInterned
+    void storeModifier(ModifierEntry& entry, const Modifier<NumberType>& modifier, ModifierDefId def) 
     {
-        return current_;
+        locals_.store(entry.def, entry.slot, modifier, def, [this](uint32_t slot, ModifierDefId moved) {
+            modifiers_[slots_.position(slot)].def = moved;
+        });
     }
 
-    NumberType max() 
+    void releaseLocal(const ModifierEntry& entry) 
     {
-        return max_;
+        locals_.release(entry.def, [this](uint32_t slot, ModifierDefId moved) {
+            modifiers_[slots_.position(slot)].def = moved;
+        });
     }
 
-    NumberType baseMax() 
+    uint32_t findSource(uint32_t source) const 
     {
-        return base_max_;
+        return sources_.find(source);
     }
 
-    bool clearModifiers() 
+    // Reapplies a modifier whose source already has an instance at slot
+    ModifierHandle restack(uint32_t slot, const Modifier<NumberType>& modifier, ModifierDefId def, StackOutcome& outcome) 
     {
-        if (modifiers_.empty()) {
-            return false;
-        }
-        
-        // Store current ratio for potential proportional scaling
-        double ratio = static_cast<double>(current_) / max_;
-        
-        // Clear all modifiers
-        modifiers_.clear();
-        
-        // Reset max to base max
-        max_ = base_max_;
-        
-        // Scale current value proportionally
-        current_ = static_cast<NumberType>(ratio * max_);
-        
-        // Ensure current doesn't exceed max
-        if (current_ > max_) {
-            current_ = max_;
+        auto& entry = modifiers_[slots_.position(slot)];
+        const StackDecision decision = decideStack(modifierOf(entry), entry.stacks, modifier, def == entry.def);
+        if (decision.replace or decision.stacks != entry.stacks) {
+            changeEntry(entry, decision.stacks, decision.replace ? &modifier : nullptr, def);
         }
-        
-        return true;
+        outcome = decision.outcome;
+        return slots_.handle(slot);
     }
 
-    // Add points with bounds checking
-    bool add(NumberType points) 
+    // Swaps what an entry contributes and refreshes max (and current if it scales).
+    // Without a modifier only the stack count changes.
+    void changeEntry(ModifierEntry& entry, uint8_t stacks, const Modifier<NumberType>* modifier = nullptr, ModifierDefId def = NotInterned) 
     {
-        // Check for potential overflow
-        if (points > std::numeric_limits<NumberType>::max() - current_) {
-            current_ = max_;
-            return false;
+        const bool proportional = (modifier ? *modifier : modifierOf(entry)).getProportionalScaling();
+        NumberType old_max = beforeChange(proportional);
+        if (mode_ == StackingMode::Aggregate) {
+            aggregateEntry(entry, false);
         }
-        
-        // Add points but cap at max
-        NumberType new_value = current_ + points;
-        if (new_value > max_) {
-            current_ = max_;
-            return false;  // Couldn't add all points
-        } else {
-            current_ = new_value;
-            return true;   // Successfully added all points
+        if (modifier) {
+            storeModifier(entry, *modifier, def);
+        }
+        entry.stacks = stacks;
+        if (mode_ == StackingMode::Aggregate) {
+            aggregateEntry(entry, true);
+            max_ = aggregateMax();
         }
+        else {
+            refreshMax();
+        }
+
+        scaleCurrent(old_max, proportional);
     }
 
-    // Remove points with bounds checking
-    bool remove(NumberType points) 
+    void releaseEntry(const ModifierEntry& entry) 
     {
-        if (points > current_) {
-            current_ = 0;
-            return false;  // Couldn't remove all points
-        } else {
-            current_ -= points;
-            return true;   // Successfully removed all points
+        const uint32_t source = modifierOf(entry).getSource();
+        releaseLocal(entry);
+        if (source != 0) {
+            sources_.erase(source);
         }
+        slots_.release(entry.slot);
     }
 
-    // Convenience method for chaining modifiers
-    PointStat& modify(std::unique_ptr<Modifier<NumberType>> modifier) {
-        addModifier(std::move(modifier));
-        return *this;
+    static constexpr uint32_t NoSlot = ModifierSlots<InlineModifiers>::NoSlot;
+
+    // Only for aggregate mode, where the order of modifiers_ means nothing
+    void swapEraseEntry(uint32_t position) 
+    {
+        releaseEntry(modifiers_[position]);
+        if (position + 1 != modifiers_.size()) {
+            modifiers_[position] = modifiers_.back();
+            slots_.move(modifiers_[position].slot, position);
+        }
+        modifiers_.pop_back();
     }
 
-private:
+    // Drops every entry whose slot was released by removeModifiers, keeping order
+    void compactEntries() 
+    {
+        uint32_t kept = 0;
+        for (uint32_t i = 0; i < modifiers_.size(); ++i) {
+            if (modifiers_[i].slot == NoSlot) {
+                continue;
+            }
+            modifiers_[kept] = modifiers_[i];
+            slots_.move(modifiers_[kept].slot, kept);
+            ++kept;
+        }
+        modifiers_.truncate(kept);
+    }
+
+    // Modifiers apply in the order they were added, so we close the gap rather
+    // than swapping the last one in. The recalculation that follows a removal
+    // walks every modifier anyway.
+    void eraseEntry(uint32_t position) 
+    {
+        releaseEntry(modifiers_[position]);
+        modifiers_.erase(position);
+        for (uint32_t i = position; i < modifiers_.size(); ++i) {
+            slots_.move(modifiers_[i].slot, i);
+        }
+    }
 
     struct _apply_results 
     {
@@ -291,13 +2002,177 @@ private:
         bool _success;
     };
 
+    static constexpr std::size_t LayerCount = static_cast<std::size_t>(ModifierLayer::Count);
+
+    void aggregate(const Modifier<NumberType>& modifier, bool adding) 
+    {
+        markDirty(modifier.getLayer());
+        if (totals_.apply(modifier, adding)) {
+            // The next aggregateMax rebuilds from whatever entries are left by then
+            pending_rebuild_ = true;
+        }
+    }
+
+    // Every stack counts as one more application of the modifier
+    void aggregateEntry(const ModifierEntry& entry, bool adding) 
+    {
+        for (uint8_t stack = 0; stack < entry.stacks; ++stack) {
+            aggregate(modifierOf(entry), adding);
+        }
+    }
+
+    void rebuildTotals() 
+    {
+        totals_ = AggregateTotals<NumberType>{};
+        dirty_from_ = 0;
+        for (const auto& entry : modifiers_) {
+            aggregateEntry(entry, true);
+        }
+        pending_rebuild_ = false;
+    }
+
+    void markDirty(ModifierLayer layer) 
+    {
+        dirty_from_ = std::min(dirty_from_, static_cast<uint8_t>(layer));
+    }
+
+    // Walks the layers in order, each one caches its output in layer_values_
+    // so only the first dirty layer and the ones after it are recomputed.
+    // The result is clamped to [1, max value].
+    NumberType aggregateMax() 
+    {
+        if (pending_rebuild_) {
+            rebuildTotals();
+        }
+
+        for (std::size_t layer = dirty_from_; layer < LayerCount; ++layer) {
+            const uint64_t input = layer == 0 ? base_max_ : layer_values_[layer - 1];
+            layer_values_[layer] = totals_.layer(static_cast<ModifierLayer>(layer), input);
+        }
+        dirty_from_ = LayerCount;
+        return AggregateTotals<NumberType>::clamp(layer_values_[LayerCount - 1]);
+    }
+
+    // Brings current up to date with the clock
+    void regenerate() 
+    {
+        const uint64_t now = PointStatClock::now();
+        const uint64_t elapsed = now > regen_tick_ ? now - regen_tick_ : 0;
+        regen_tick_ = now;
+        if (regen_ == 0 or elapsed == 0) [[likely]] {
+            return;
+        }
+        flushScale();
+
+        // Negate in unsigned so the most negative rate doesn't overflow
+        const uint64_t rate = static_cast<uint64_t>(static_cast<int64_t>(regen_));
+        const uint64_t amount = StatMath::saturatingMultiply(regen_ > 0 ? rate : 0 - rate, elapsed);
+        if (regen_ > 0) {
+            if (current_ < max_) {
+                current_ = amount >= static_cast<uint64_t>(max_ - current_) ? max_ : static_cast<NumberType>(current_ + amount);
+            }
+        }
+        else {
+            current_ = amount >= current_ ? 0 : static_cast<NumberType>(current_ - amount);
+        }
+        notifyThresholds();
+    }
+
+    // Sequential max after the entries changed, inside a transaction it's only marked stale
+    void refreshMax() 
+    {
+        if (modify_.depth > 0) {
+            modify_.stale = true;
+            return;
+        }
+        recalculateMax();
+    }
+
+    // Inside a transaction commit does the rescale, see beforeChange
+    void scaleCurrent(NumberType old_max, bool proportional) 
+    {
+        if (modify_.depth == 0 and proportional and old_max > 0) {
+            rescaleCurrent(old_max);
+        }
+    }
+
+    // Called before anything that moves max, returns max as it is now.
+    // Inside a transaction the proportional changes come in runs, and a run scales current
+    // by max at its end over max at its start, every step in between cancels out. So max
+    // only has to be settled where a run starts or stops, not once per change.
+    NumberType beforeChange(bool proportional) 
+    {
+        if (modify_.depth == 0 or proportional == modify_.in_run) {
+            return max_;
+        }
+        const NumberType settled = settledMax();
+        if (proportional) {
+            modify_.run_from = settled;
+        }
+        else {
+            modify_.scale.accumulate(modify_.run_from, settled, current_);
+        }
+        modify_.in_run = proportional;
+        return settled;
+    }
+
+    // Sequential max after any removals the transaction put off
+    NumberType settledMax() 
+    {
+        if (modify_.stale) {
+            modify_.stale = false;
+            recalculateMax();
+        }
+        return max_;
+    }
+
+    // Something inside a transaction is about to change current directly (points, regen),
+    // so whatever scaling came before it has to land first, and only that
+    void flushScale() 
+    {
+        if (modify_.depth == 0) {
+            return;
+        }
+        settledMax();
+        if (modify_.in_run) {
+            modify_.scale.accumulate(modify_.run_from, max_, current_);
+            modify_.run_from = max_;
+        }
+        modify_.scale.apply(current_);
+    }
+
+    // Keeps current at the same fraction of max after max moved away from old_max
+    void rescaleCurrent(NumberType old_max) 
+    {
+        if (old_max == max_ or current_ == 0) {
+            return;
+        }
+        // Rounds down, exact integer math so lockstep sims agree everywhere
+        const NumberType scaled = current_ < old_max ? StatMath::rescale(current_, max_, old_max) : max_;
+        
+        // Ensure current doesn't become zero due to rounding
+        current_ = scaled > 0 ? scaled : NumberType{1};
+    }
+
     // Recalculate max value from base_max_ and all modifiers
     void recalculateMax() {
+        if (mode_ == StackingMode::Aggregate) {
+            rebuildTotals();
+            max_ = aggregateMax();
+            return;
+        }
+
         max_ = base_max_;
-        for (const auto& mod : modifiers_) {
-            NumberType result = applyModifier(*mod);
-            if (result > 0) {
-                max_ = result;
+        for (const auto& entry : modifiers_) {
+            // Holes removeModifiers hasn't closed yet
+            if (entry.slot == NoSlot) {
+                continue;
+            }
+            for (uint8_t stack = 0; stack < entry.stacks; ++stack) {
+                NumberType result = applyModifier(modifierOf(entry));
+                if (result > 0) {
+                    max_ = result;
+                }
             }
         }
     }
@@ -343,6 +2218,22 @@ private:
                 return 0;
             }
 
+            case Modifier<NumberType>::Type::Cap:
+            {
+                // a cap can never overflow or reach zero, the constructor saw to that
+                return std::min(max_, modifier.getValue());
+            }
+
+            case Modifier<NumberType>::Type::AddPercent:
+            case Modifier<NumberType>::Type::SubtractPercent:
+            {
+                if (const auto results = canApplyPercent(modifier); results._success) 
+                {
+                    return results._value;
+                }
+                return 0;
+            }
+
             [[unlikely]] default:
             {
                 return 0;
@@ -352,12 +2243,23 @@ private:
         return 0;
     }
 
+    // A modifier went out of range, the policy decides what max becomes (0 refuses it)
+    _apply_results outOfRange(NumberType wrapped, NumberType limit) 
+    {
+        const NumberType value = Policy::modifier(wrapped, limit);
+        return _apply_results{value, value > 0};
+    }
+
     _apply_results canApplyMultiplier(const Modifier<NumberType>& modifier)
     {
-        const NumberType temp = modifier.getValue() * max_;
-        if (temp < max_ && modifier.getValue() > 1) {
-            // Overflow detected
-            return _apply_results{0, false};
+        // Widened first so two promoted uint16s can't make a signed overflow
+        const NumberType temp = static_cast<NumberType>(static_cast<std::common_type_t<NumberType, unsigned>>(modifier.getValue()) * max_);
+        if constexpr (Policy::Checked) {
+            // Dividing back out catches every wrap, not just the ones that land below max
+            if (modifier.getValue() > 1 and temp / modifier.getValue() != max_) {
+                // Overflow detected
+                return outOfRange(temp, std::numeric_limits<NumberType>::max());
+            }
         }
         return _apply_results{temp, true};
     }
@@ -369,42 +2271,89 @@ private:
         }
         
         const NumberType temp = max_ / modifier.getValue();
-        if (temp == 0) {
-            // we disallow equaling zero because that would
-            // bypass our built in type safety
-            return _apply_results{0, false};
+        if constexpr (Policy::Checked) {
+            if (temp == 0) {
+                // we disallow equaling zero because that would
+                // bypass our built in type safety
+                return outOfRange(temp, NumberType{1});
+            }
         }
         return _apply_results{temp, true};
     }
 
     _apply_results canApplyAdditive(const Modifier<NumberType>& modifier)
     {
-        if (max_ > std::numeric_limits<NumberType>::max() - modifier.getValue()) {
-            // Overflow detected
-            return _apply_results{0, false};
-        }
         const NumberType temp = max_ + modifier.getValue();
+        if constexpr (Policy::Checked) {
+            if (max_ > std::numeric_limits<NumberType>::max() - modifier.getValue()) {
+                // Overflow detected
+                return outOfRange(temp, std::numeric_limits<NumberType>::max());
+            }
+        }
+        return _apply_results{temp, true};
+    }
+
+    _apply_results canApplyPercent(const Modifier<NumberType>& modifier)
+    {
+        // 64 bit and saturating, a huge AddPercent must not wrap into a small factor
+        const uint64_t factor = modifier.getType() == Modifier<NumberType>::Type::AddPercent
+            ? StatMath::saturatingAdd(StatMath::BasisPointsOne, modifier.getValue())
+            : StatMath::BasisPointsOne - modifier.getValue();
+
+        bool overflow = false;
+        const uint64_t scaled = StatMath::multiplyDivide(max_, factor, StatMath::BasisPointsOne, overflow);
+        const NumberType temp = static_cast<NumberType>(scaled);
+        if constexpr (Policy::Checked) {
+            // overflow is how a 64 bit stat finds out, the narrower ones just compare
+            if (overflow or scaled > std::numeric_limits<NumberType>::max()) {
+                // Overflow detected
+                return outOfRange(temp, std::numeric_limits<NumberType>::max());
+            }
+
+            if (temp == 0) {
+                return outOfRange(temp, NumberType{1});
+            }
+        }
         return _apply_results{temp, true};
     }
 
     _apply_results canApplySubtractive(const Modifier<NumberType>& modifier)
     {
-        if (modifier.getValue() >= max_) {
-            // Would result in zero or underflow
-            return _apply_results{0, false};
-        } 
-        
         const NumberType temp = max_ - modifier.getValue();
-        // Because this function is internally used to determine the max value
-        // the final value is not permitted to be 0 as that violates our safety.
-        if (temp == 0) {
-            return _apply_results{0, false};
-        } 
+        if constexpr (Policy::Checked) {
+            // Because this function is internally used to determine the max value
+            // the final value is not permitted to be 0 as that violates our safety.
+            if (modifier.getValue() >= max_) {
+                // Would result in zero or underflow
+                return outOfRange(temp, NumberType{1});
+            } 
+        }
         return _apply_results{temp, true};
     }
 
-    std::vector<std::unique_ptr<Modifier<NumberType>>> modifiers_;
+    SmallVector<ModifierEntry, InlineModifiers> modifiers_;
+    ModifierSlots<InlineModifiers> slots_;
+    ModifierSourceIndex sources_;
+    LocalModifiers<NumberType> locals_;
+    AggregateTotals<NumberType> totals_;
+    std::array<uint64_t, LayerCount> layer_values_{};
+    uint8_t dirty_from_ = 0;
+    bool pending_rebuild_ = false;
     NumberType current_;
     NumberType base_max_;
     NumberType max_;
+    StackingMode mode_;
+    uint64_t regen_tick_;
+    RegenType regen_ = 0;
+    ThresholdHolder thresholds_;
+
+    struct ModifyState 
+    {
+        uint32_t depth = 0;
+        bool stale = false;     // sequential max needs a rebuild before anyone trusts it
+        bool in_run = false;    // the last change scaled current, run_from is max before the run
+        NumberType run_from = 0;
+        PendingScale scale;     // what commit multiplies current by
+    };
+    ModifyState modify_;
 };
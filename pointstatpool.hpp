@@ -0,0 +1,464 @@
+// MIT License
+
+// Author : Codinablack@github.com
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+#include "pointbasedstat.hpp"
+
+// Runtime ISA dispatch only makes sense when the build isn't already targeting AVX2
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__)) && !defined(__AVX2__)
+#define POINTSTATPOOL_DISPATCH 1
+#else
+#define POINTSTATPOOL_DISPATCH 0
+#endif
+
+// The loops behind PointStatPool. They're written branch free over plain arrays
+// so the compiler turns them into saturating vector code, and each one is
+// built twice, once for the baseline and once for AVX2, picked at runtime.
+// Every kernel writes 1 to clamped[i] where the matching PointStat::add or
+// PointStat::remove would have returned false, and returns how many did.
+namespace PoolKernels {
+
+    template<class N>
+    [[gnu::always_inline]] inline std::size_t damage(N* current, const N* amounts, uint8_t* clamped, std::size_t count) 
+    {
+        std::size_t total = 0;
+        for (std::size_t i = 0; i < count; ++i) {
+            const N c = current[i];
+            const N a = amounts[i];
+            const bool clamp = a > c;
+            current[i] = clamp ? N{0} : static_cast<N>(c - a);
+            clamped[i] = clamp;
+            total += clamp;
+        }
+        return total;
+    }
+
+    template<class N>
+    [[gnu::always_inline]] inline std::size_t heal(N* current, const N* max, const N* amounts, uint8_t* clamped, std::size_t count) 
+    {
+        std::size_t total = 0;
+        for (std::size_t i = 0; i < count; ++i) {
+            const N c = current[i];
+            const N m = max[i];
+            const N a = amounts[i];
+            // room can't overflow and checking against it covers the overflow add() guards against
+            const bool clamp = a > static_cast<N>(m - c);
+            current[i] = clamp ? m : static_cast<N>(c + a);
+            clamped[i] = clamp;
+            total += clamp;
+        }
+        return total;
+    }
+
+    // One shield layer soaking up what it can of remaining, absorbed gets what it took
+    template<class N>
+    [[gnu::always_inline]] inline void absorb(N* shield, N* remaining, N* absorbed, std::size_t count) 
+    {
+        for (std::size_t i = 0; i < count; ++i) {
+            const N r = remaining[i];
+            const N s = shield[i];
+            const N take = r < s ? r : s;
+            shield[i] = static_cast<N>(s - take);
+            remaining[i] = static_cast<N>(r - take);
+            absorbed[i] = take;
+        }
+    }
+
+    // limit is the largest rate that can be multiplied by ticks without wrapping,
+    // anything above it fills the stat anyway
+    template<class N>
+    [[gnu::always_inline]] inline void regenerate(N* current, const N* max, const N* rates, N ticks, N limit, std::size_t count) 
+    {
+        for (std::size_t i = 0; i < count; ++i) {
+            const N c = current[i];
+            const N m = max[i];
+            const N r = rates[i];
+            // Promoted multiplication of two uint16 would be a signed overflow, so widen first
+            const N gain = static_cast<N>(static_cast<std::common_type_t<N, unsigned>>(r) * ticks);
+            const bool fill = r > limit or gain > static_cast<N>(m - c);
+            current[i] = fill ? m : static_cast<N>(c + gain);
+        }
+    }
+
+#if POINTSTATPOOL_DISPATCH
+    template<class N>
+    [[gnu::target("avx2")]] std::size_t damageAvx2(N* current, const N* amounts, uint8_t* clamped, std::size_t count) 
+    {
+        return damage(current, amounts, clamped, count);
+    }
+
+    template<class N>
+    [[gnu::target("avx2")]] std::size_t healAvx2(N* current, const N* max, const N* amounts, uint8_t* clamped, std::size_t count) 
+    {
+        return heal(current, max, amounts, clamped, count);
+    }
+
+    template<class N>
+    [[gnu::target("avx2")]] void absorbAvx2(N* shield, N* remaining, N* absorbed, std::size_t count) 
+    {
+        absorb(shield, remaining, absorbed, count);
+    }
+
+    template<class N>
+    [[gnu::target("avx2")]] void regenerateAvx2(N* current, const N* max, const N* rates, N ticks, N limit, std::size_t count) 
+    {
+        regenerate(current, max, rates, ticks, limit, count);
+    }
+
+    inline bool hasAvx2() 
+    {
+        static const bool supported = [] {
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2") != 0;
+        }();
+        return supported;
+    }
+#endif
+
+}
+
+// Structure of arrays storage for the plain PointStats of a lot of entities
+// (think the health of every mob in a zone), so an AoE or a regen tick runs as one tight
+// loop over contiguous arrays instead of a virtual-ish call per object.
+// The stats here have no modifiers, max is whatever the owner sets it to. Each stat also keeps
+// a base max, which zone wide scaling (difficulty, level sync) works from, see scaleMaxes.
+// Indices are stable, they're handed out by create and never move.
+template<PositiveNumber NumberType>
+class PointStatPool {
+public:
+
+    using Index = uint32_t;
+
+    explicit PointStatPool(std::size_t reserve = 0) 
+        : regen_tick_(PointStatClock::now())
+    {
+        current_.reserve(reserve);
+        max_.reserve(reserve);
+        base_max_.reserve(reserve);
+        regen_.reserve(reserve);
+    }
+
+    // Same rules as the PointStat constructor
+    Index create(NumberType initial, NumberType max) 
+    {
+        if (max <= 0) 
+        {
+            throw std::invalid_argument("PointStat max must be positive");
+        }
+        current_.push_back(std::min(initial, max));
+        max_.push_back(max);
+        base_max_.push_back(max);
+        regen_.push_back(0);
+        for (auto& layer : shields_) {
+            layer.push_back(0);
+        }
+        return static_cast<Index>(current_.size() - 1);
+    }
+
+    std::size_t size() const 
+    {
+        return current_.size();
+    }
+
+    NumberType current(Index index) const 
+    {
+        return current_[index];
+    }
+
+    NumberType max(Index index) const 
+    {
+        return max_[index];
+    }
+
+    NumberType baseMax(Index index) const 
+    {
+        return base_max_[index];
+    }
+
+    // With proportional current keeps its fraction of max (same rounding as PointStat),
+    // otherwise it's only clamped down if it no longer fits. The base max stays as it was.
+    void setMax(Index index, NumberType max, bool proportional = false) 
+    {
+        setMaxes(index, std::span<const NumberType>(&max, 1), proportional);
+    }
+
+    // Dense batch of setMax, maxes[i] goes to stat first + i
+    void setMaxes(Index first, std::span<const NumberType> maxes, bool proportional = false) 
+    {
+        checkRange(first, maxes.size());
+        for (std::size_t i = 0; i < maxes.size(); ++i) {
+            resize(first + i, maxes[i], proportional);
+        }
+    }
+
+    // Changes the base max and puts max back on it, dropping whatever scaling was on top
+    void setBaseMax(Index index, NumberType base, bool proportional = false) 
+    {
+        checkRange(index, 1);
+        base_max_[index] = std::max<NumberType>(base, 1);
+        resize(index, base_max_[index], proportional);
+    }
+
+    // max becomes basis_points of the base max for count stats from first.
+    // It always starts from the base, so scaling 150% and later 80% gives 80% of base
+    // instead of compounding (or drifting with the rounding) like repeated setMax calls would.
+    void scaleMaxes(Index first, std::size_t count, uint32_t basis_points, bool proportional = false) 
+    {
+        checkRange(first, count);
+        constexpr uint64_t most = std::numeric_limits<NumberType>::max();
+        for (std::size_t i = first; i < first + count; ++i) {
+            const uint64_t scaled = StatMath::multiplyDivide(base_max_[i], basis_points, StatMath::BasisPointsOne);
+            resize(static_cast<Index>(i), static_cast<NumberType>(std::min(scaled, most)), proportional);
+        }
+    }
+
+    // Points gained per PointStatClock tick, applied by regenerate
+    void setRegen(Index index, NumberType per_tick) 
+    {
+        regen_[index] = per_tick;
+    }
+
+    // Absorb layers in front of current, layer 0 is hit first. Every stat has every layer,
+    // one without that shield up just has 0 in it. Returns the new layer's index.
+    std::size_t addShieldLayer() 
+    {
+        shields_.emplace_back(current_.size(), NumberType{0});
+        return shields_.size() - 1;
+    }
+
+    std::size_t shieldLayers() const 
+    {
+        return shields_.size();
+    }
+
+    NumberType shield(Index index, std::size_t layer) const 
+    {
+        return shields_[layer][index];
+    }
+
+    void setShield(Index index, std::size_t layer, NumberType points) 
+    {
+        shields_[layer][index] = points;
+    }
+
+    // Contiguous views, for owners that want to run their own passes
+    std::span<NumberType> currents() { return current_; }
+    std::span<const NumberType> maxes() const { return max_; }
+
+    // PointStat::remove for every target, targets may repeat.
+    // clamped gets a flag per target (or can be left empty), returns how many were clamped.
+    // The indexed versions stay scalar loops. A repeated target has to take its hits one after
+    // the other, which a gather, kernel, scatter pass can't do, and the gather and scatter are
+    // each as much work as this loop already is. Batches that need the kernels use the dense ones.
+    std::size_t applyDamage(std::span<const Index> targets, std::span<const NumberType> amounts, std::span<uint8_t> clamped = {}) 
+    {
+        checkBatch(targets.size(), amounts.size(), clamped);
+        std::size_t total = 0;
+        for (std::size_t i = 0; i < targets.size(); ++i) {
+            NumberType& c = current_[targets[i]];
+            const bool clamp = amounts[i] > c;
+            c = clamp ? NumberType{0} : static_cast<NumberType>(c - amounts[i]);
+            total += clamp;
+            if (not clamped.empty()) {
+                clamped[i] = clamp;
+            }
+        }
+        return total;
+    }
+
+    // The AoE case, everyone takes the same hit
+    std::size_t applyDamage(std::span<const Index> targets, NumberType amount, std::span<uint8_t> clamped = {}) 
+    {
+        checkBatch(targets.size(), targets.size(), clamped);
+        std::size_t total = 0;
+        for (std::size_t i = 0; i < targets.size(); ++i) {
+            NumberType& c = current_[targets[i]];
+            const bool clamp = amount > c;
+            c = clamp ? NumberType{0} : static_cast<NumberType>(c - amount);
+            total += clamp;
+            if (not clamped.empty()) {
+                clamped[i] = clamp;
+            }
+        }
+        return total;
+    }
+
+    // PointStat::add for every target, targets may repeat
+    std::size_t applyHeal(std::span<const Index> targets, std::span<const NumberType> amounts, std::span<uint8_t> clamped = {}) 
+    {
+        checkBatch(targets.size(), amounts.size(), clamped);
+        std::size_t total = 0;
+        for (std::size_t i = 0; i < targets.size(); ++i) {
+            NumberType& c = current_[targets[i]];
+            const NumberType m = max_[targets[i]];
+            const bool clamp = amounts[i] > static_cast<NumberType>(m - c);
+            c = clamp ? m : static_cast<NumberType>(c + amounts[i]);
+            total += clamp;
+            if (not clamped.empty()) {
+                clamped[i] = clamp;
+            }
+        }
+        return total;
+    }
+
+    // Dense versions, amounts[i] goes to stat first + i.
+    // These are the vectorised ones, so spawn things that get hit together next to each other.
+    std::size_t applyDamage(Index first, std::span<const NumberType> amounts, std::span<uint8_t> clamped = {}) 
+    {
+        checkRange(first, amounts.size());
+        uint8_t* flags = flagsFor(amounts.size(), clamped);
+#if POINTSTATPOOL_DISPATCH
+        if (PoolKernels::hasAvx2()) {
+            return PoolKernels::damageAvx2(current_.data() + first, amounts.data(), flags, amounts.size());
+        }
+#endif
+        return PoolKernels::damage(current_.data() + first, amounts.data(), flags, amounts.size());
+    }
+
+    std::size_t applyHeal(Index first, std::span<const NumberType> amounts, std::span<uint8_t> clamped = {}) 
+    {
+        checkRange(first, amounts.size());
+        uint8_t* flags = flagsFor(amounts.size(), clamped);
+#if POINTSTATPOOL_DISPATCH
+        if (PoolKernels::hasAvx2()) {
+            return PoolKernels::healAvx2(current_.data() + first, max_.data() + first, amounts.data(), flags, amounts.size());
+        }
+#endif
+        return PoolKernels::heal(current_.data() + first, max_.data() + first, amounts.data(), flags, amounts.size());
+    }
+
+    // Dense damage that goes through the shield layers first, one kernel pass per layer.
+    // absorbed is optional, if given it holds shieldLayers() rows of amounts.size(),
+    // row l being what layer l took from each stat. clamped is about current only, like applyDamage.
+    std::size_t applyShieldedDamage(Index first, std::span<const NumberType> amounts, std::span<NumberType> absorbed = {}, std::span<uint8_t> clamped = {}) 
+    {
+        const std::size_t count = amounts.size();
+        checkRange(first, count);
+        if (not absorbed.empty() and absorbed.size() < count * shields_.size()) [[unlikely]] {
+            throw std::invalid_argument("PointStatPool batch spans don't match");
+        }
+        remaining_.assign(amounts.begin(), amounts.end());
+        if (absorbed.empty()) {
+            taken_.resize(std::max(taken_.size(), count));
+        }
+
+        for (std::size_t layer = 0; layer < shields_.size(); ++layer) {
+            NumberType* shield = shields_[layer].data() + first;
+            NumberType* took = absorbed.empty() ? taken_.data() : absorbed.data() + layer * count;
+#if POINTSTATPOOL_DISPATCH
+            if (PoolKernels::hasAvx2()) {
+                PoolKernels::absorbAvx2(shield, remaining_.data(), took, count);
+                continue;
+            }
+#endif
+            PoolKernels::absorb(shield, remaining_.data(), took, count);
+        }
+        return applyDamage(first, std::span<const NumberType>(remaining_), clamped);
+    }
+
+    // Catches every stat up to PointStatClock in a single pass, call it once per tick
+    // (or less often, the result is the same as long as nothing was damaged in between)
+    void regenerate() 
+    {
+        const uint64_t now = PointStatClock::now();
+        const uint64_t elapsed = now > regen_tick_ ? now - regen_tick_ : 0;
+        regen_tick_ = now;
+        if (elapsed == 0 or current_.empty()) {
+            return;
+        }
+
+        // Past the range of NumberType any non zero rate fills the stat, so clamping ticks is exact
+        constexpr uint64_t most = std::numeric_limits<NumberType>::max();
+        const NumberType ticks = static_cast<NumberType>(std::min(elapsed, most));
+        const NumberType limit = static_cast<NumberType>(most / ticks);
+#if POINTSTATPOOL_DISPATCH
+        if (PoolKernels::hasAvx2()) {
+            PoolKernels::regenerateAvx2(current_.data(), max_.data(), regen_.data(), ticks, limit, current_.size());
+            return;
+        }
+#endif
+        PoolKernels::regenerate(current_.data(), max_.data(), regen_.data(), ticks, limit, current_.size());
+    }
+
+private:
+
+    void checkBatch(std::size_t targets, std::size_t amounts, std::span<uint8_t> clamped) const 
+    {
+        if (targets != amounts or (not clamped.empty() and clamped.size() < targets)) [[unlikely]] {
+            throw std::invalid_argument("PointStatPool batch spans don't match");
+        }
+    }
+
+    void checkRange(Index first, std::size_t count) const 
+    {
+        if (first > current_.size() or count > current_.size() - first) [[unlikely]] {
+            throw std::out_of_range("PointStatPool range past the end of the pool");
+        }
+    }
+
+    // Shared by everything that moves max, next is raised to 1 like PointStat does
+    void resize(Index index, NumberType next, bool proportional) 
+    {
+        next = std::max<NumberType>(next, 1);
+        NumberType& current = current_[index];
+        NumberType& max = max_[index];
+        if (proportional and current > 0) {
+            const NumberType scaled = current < max ? StatMath::rescale(current, next, max) : next;
+            current = scaled > 0 ? scaled : NumberType{1};
+        }
+        else {
+            current = std::min(current, next);
+        }
+        max = next;
+    }
+
+    // Kernels always write flags, when the caller doesn't want them they land in scratch
+    uint8_t* flagsFor(std::size_t count, std::span<uint8_t> clamped) 
+    {
+        if (clamped.empty()) {
+            scratch_.resize(std::max(scratch_.size(), count));
+            return scratch_.data();
+        }
+        if (clamped.size() < count) [[unlikely]] {
+            throw std::invalid_argument("PointStatPool batch spans don't match");
+        }
+        return clamped.data();
+    }
+
+    std::vector<NumberType> current_;
+    std::vector<NumberType> max_;
+    std::vector<NumberType> base_max_;
+    std::vector<NumberType> regen_;
+    std::vector<std::vector<NumberType>> shields_;
+    std::vector<NumberType> remaining_;
+    std::vector<NumberType> taken_;
+    std::vector<uint8_t> scratch_;
+    uint64_t regen_tick_;
+};
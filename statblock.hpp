@@ -0,0 +1,450 @@
+// MIT License
+
+// Author : Codinablack@github.com
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include "pointbasedstat.hpp"
+
+// Count for a StatBlock whose resources are only known at runtime
+inline constexpr std::size_t DynamicStats = 0;
+
+// All of an entity's resources (health, mana, stamina, rage, shield...) in one object.
+// The resources sit next to each other and share one modifier list, modifiers name the
+// resource they apply to, and a change recalculates only the resources it touched with a
+// single pass over that list. With a fixed Count everything lives inside the block,
+// the DynamicStats version takes the count at runtime and keeps the first few inline.
+// Modifiers stack the way PointStat's aggregate mode does:
+// min((base + adds - subtracts) * percents * multipliers / divisors, caps), clamped to [1, numeric max].
+// Sources, stack policies, by value modifiers and transactions all behave like PointStat's,
+// with a source's instance tracked per resource.
+// Stat ids are plain indices, an enum class with a uint8_t underlying type works well,
+// and one past the last resource throws std::out_of_range.
+template<PositiveNumber NumberType, std::size_t Count = DynamicStats>
+class StatBlock {
+public:
+
+    // Up to 64 resources, so the dirty set is one word
+    static_assert(Count <= 64, "StatBlock holds at most 64 resources");
+
+    using StatId = uint8_t;
+
+    // Fixed schema, one max per resource in id order: StatBlock<uint32_t, 3> block(hp, mana, rage)
+    template<class... Maxes>
+        requires (Count != DynamicStats and sizeof...(Maxes) == Count)
+    explicit StatBlock(Maxes... maxes) 
+    {
+        const std::array<NumberType, Count> values{static_cast<NumberType>(maxes)...};
+        for (std::size_t i = 0; i < Count; ++i) {
+            resources_[i] = makeResource(values[i]);
+        }
+    }
+
+    // Runtime schema
+    explicit StatBlock(std::span<const NumberType> maxes) 
+        requires (Count == DynamicStats)
+    {
+        if (maxes.size() > 64) 
+        {
+            throw std::invalid_argument("StatBlock holds at most 64 resources");
+        }
+        for (NumberType max : maxes) {
+            resources_.push_back(makeResource(max));
+        }
+    }
+
+    std::size_t size() const 
+    {
+        return resources_.size();
+    }
+
+    template<class Id>
+    NumberType current(Id id) const 
+    {
+        return resources_[index(id)].current;
+    }
+
+    template<class Id>
+    NumberType max(Id id) const 
+    {
+        return resources_[index(id)].max;
+    }
+
+    template<class Id>
+    NumberType baseMax(Id id) const 
+    {
+        return resources_[index(id)].base_max;
+    }
+
+    // Same as PointStat::add, false if it stopped at max
+    template<class Id>
+    bool add(Id id, NumberType points) 
+    {
+        const std::size_t stat = index(id);
+        flushScale(stat);
+        Resource& resource = resources_[stat];
+        const bool fits = resource.current <= resource.max and points <= static_cast<NumberType>(resource.max - resource.current);
+        resource.current = fits ? static_cast<NumberType>(resource.current + points) : resource.max;
+        return fits;
+    }
+
+    // Same as PointStat::remove, false if it stopped at 0
+    template<class Id>
+    bool remove(Id id, NumberType points) 
+    {
+        const std::size_t stat = index(id);
+        flushScale(stat);
+        Resource& resource = resources_[stat];
+        const bool fits = points <= resource.current;
+        resource.current = fits ? static_cast<NumberType>(resource.current - points) : NumberType{0};
+        return fits;
+    }
+
+    template<class Id>
+    void setBaseMax(Id id, NumberType base_max, bool proportional = true) 
+    {
+        const std::size_t stat = index(id);
+        const NumberType old_max = beforeChange(stat, proportional);
+        resources_[stat].base_max = std::max<NumberType>(base_max, 1);
+        changed(stat, old_max, proportional);
+    }
+
+    // Same as PointStat::addModifier. A modifier passed by value is kept in the block,
+    // a ModifierDefId only by id, and a source that's already on this resource follows its StackPolicy.
+    template<class Id>
+    ModifierHandle addModifier(Id id, const Modifier<NumberType>& modifier) 
+    {
+        StackOutcome outcome;
+        return addModifier(id, modifier, outcome);
+    }
+
+    template<class Id>
+    ModifierHandle addModifier(Id id, const Modifier<NumberType>& modifier, StackOutcome& outcome) 
+    {
+        return insertModifier(index(id), modifier, NotInterned, outcome);
+    }
+
+    template<class Id>
+    ModifierHandle addModifier(Id id, ModifierDefId def) 
+    {
+        StackOutcome outcome;
+        return addModifier(id, def, outcome);
+    }
+
+    template<class Id>
+    ModifierHandle addModifier(Id id, ModifierDefId def, StackOutcome& outcome) 
+    {
+        return insertModifier(index(id), ModifierDefs<NumberType>::get(def), def, outcome);
+    }
+
+    bool removeModifier(ModifierHandle handle) 
+    {
+        if (not hasModifier(handle)) {
+            return false;
+        }
+        const uint32_t position = slots_.position(handle.index);
+        const std::size_t stat = entries_[position].stat;
+        const bool proportional = modifierOf(entries_[position]).getProportionalScaling();
+        const NumberType old_max = beforeChange(stat, proportional);
+        eraseEntry(position);
+        changed(stat, old_max, proportional);
+        return true;
+    }
+
+    bool hasModifier(ModifierHandle handle) const 
+    {
+        return slots_.contains(handle);
+    }
+
+    // The instance a source currently has on a resource, empty if there is none
+    template<class Id>
+    ModifierHandle findModifier(Id id, uint32_t source) const 
+    {
+        const uint32_t slot = source != 0 ? sources_.find(sourceKey(index(id), source)) : NoSlot;
+        return slot != NoSlot ? slots_.handle(slot) : ModifierHandle{};
+    }
+
+    uint8_t stacks(ModifierHandle handle) const 
+    {
+        return hasModifier(handle) ? entries_[slots_.position(handle.index)].stacks : 0;
+    }
+
+    // Same as PointStat::beginModify, per resource. An equipment change inside one transaction
+    // recalculates every resource it touched in a single pass when it commits, and each one's
+    // current is scaled by its proportional changes only, rounded once.
+    void beginModify() 
+    {
+        if (depth_++ == 0) {
+            in_run_ = 0;
+        }
+    }
+
+    void commit() 
+    {
+        if (depth_ == 0 or --depth_ > 0) {
+            return;
+        }
+        settle(dirty_);
+        for (uint64_t bits = in_run_; bits != 0; bits &= bits - 1) {
+            Resource& resource = resources_[std::countr_zero(bits)];
+            resource.scale.accumulate(resource.run_from, resource.max, resource.current);
+        }
+        in_run_ = 0;
+        for (auto& resource : resources_) {
+            resource.scale.apply(resource.current);
+            resource.current = std::min(resource.current, resource.max);
+        }
+    }
+
+private:
+
+    struct Resource 
+    {
+        NumberType current;
+        NumberType base_max;
+        NumberType max;
+        NumberType run_from;    // max when the current run of proportional changes began
+        PendingScale scale;     // what commit multiplies current by
+    };
+
+    // Like PointStat's entries, by value modifiers live in locals_
+    struct Entry 
+    {
+        ModifierDefId def;
+        uint32_t slot;
+        StatId stat;
+        uint8_t stacks;
+    };
+
+    static constexpr std::size_t InlineModifiers = 8;
+    static constexpr uint32_t NoSlot = ModifierSlots<InlineModifiers>::NoSlot;
+    static constexpr ModifierDefId NotInterned = LocalModifiers<NumberType>::NotInterned;
+
+    using Resources = std::conditional_t<Count == DynamicStats, SmallVector<Resource, 8>, std::array<Resource, Count>>;
+
+    static Resource makeResource(NumberType max) 
+    {
+        if (max <= 0) 
+        {
+            throw std::invalid_argument("StatBlock max must be positive");
+        }
+        return Resource{max, max, max, max, PendingScale{}};
+    }
+
+    template<class Id>
+    std::size_t index(Id id) const 
+    {
+        const auto stat = static_cast<std::size_t>(id);
+        if (stat >= resources_.size()) [[unlikely]]
+        {
+            throw std::out_of_range("StatBlock has no resource with that id");
+        }
+        return stat;
+    }
+
+    // Sources are per resource, so the same buff can sit on health and mana at once
+    static uint64_t sourceKey(std::size_t stat, uint32_t source) 
+    {
+        return static_cast<uint64_t>(stat) << 32 | source;
+    }
+
+    ModifierHandle insertModifier(std::size_t stat, const Modifier<NumberType>& modifier, ModifierDefId def, StackOutcome& outcome) 
+    {
+        if (modifier.getSource() != 0) {
+            if (uint32_t slot = sources_.find(sourceKey(stat, modifier.getSource())); slot != NoSlot) {
+                return restack(slot, modifier, def, outcome);
+            }
+        }
+
+        const bool proportional = modifier.getProportionalScaling();
+        const NumberType old_max = beforeChange(stat, proportional);
+        ModifierHandle handle = slots_.acquire(static_cast<uint32_t>(entries_.size()));
+        entries_.push_back(Entry{ModifierDefId{}, handle.index, static_cast<StatId>(stat), 1});
+        storeModifier(entries_.back(), modifier, def);
+        if (modifier.getSource() != 0) {
+            sources_.insert(sourceKey(stat, modifier.getSource()), handle.index);
+        }
+        changed(stat, old_max, proportional);
+        outcome = StackOutcome::Added;
+        return handle;
+    }
+
+    // Reapplies a modifier whose source already has an instance at slot
+    ModifierHandle restack(uint32_t slot, const Modifier<NumberType>& modifier, ModifierDefId def, StackOutcome& outcome) 
+    {
+        Entry& entry = entries_[slots_.position(slot)];
+        const StackDecision decision = decideStack(modifierOf(entry), entry.stacks, modifier, def == entry.def);
+        if (decision.replace or decision.stacks != entry.stacks) {
+            const bool proportional = (decision.replace ? modifier : modifierOf(entry)).getProportionalScaling();
+            const NumberType old_max = beforeChange(entry.stat, proportional);
+            if (decision.replace) {
+                storeModifier(entry, modifier, def);
+            }
+            entry.stacks = decision.stacks;
+            changed(entry.stat, old_max, proportional);
+        }
+        outcome = decision.outcome;
+        return slots_.handle(slot);
+    }
+
+    const Modifier<NumberType>& modifierOf(const Entry& entry) const 
+    {
+        return locals_.get(entry.def);
+    }
+
+    void storeModifier(Entry& entry, const Modifier<NumberType>& modifier, ModifierDefId def) 
+    {
+        locals_.store(entry.def, entry.slot, modifier, def, [this](uint32_t slot, ModifierDefId moved) {
+            entries_[slots_.position(slot)].def = moved;
+        });
+    }
+
+    // Order doesn't matter, so the last entry fills the gap
+    void eraseEntry(uint32_t position) 
+    {
+        const Entry& entry = entries_[position];
+        if (const uint32_t source = modifierOf(entry).getSource(); source != 0) {
+            sources_.erase(sourceKey(entry.stat, source));
+        }
+        locals_.release(entry.def, [this](uint32_t slot, ModifierDefId moved) {
+            entries_[slots_.position(slot)].def = moved;
+        });
+        slots_.release(entry.slot);
+        if (position + 1 != entries_.size()) {
+            entries_[position] = entries_.back();
+            slots_.move(entries_[position].slot, position);
+        }
+        entries_.pop_back();
+    }
+
+    // Called before anything that moves a resource's max, returns its max as it is now.
+    // Works like PointStat::beforeChange: inside a transaction max is only settled where
+    // a run of proportional changes starts or stops, every step inside a run cancels out.
+    NumberType beforeChange(std::size_t stat, bool proportional) 
+    {
+        Resource& resource = resources_[stat];
+        const uint64_t bit = uint64_t{1} << stat;
+        if (depth_ == 0 or proportional == static_cast<bool>(in_run_ & bit)) {
+            return resource.max;
+        }
+        settle(bit);
+        if (proportional) {
+            resource.run_from = resource.max;
+        }
+        else {
+            resource.scale.accumulate(resource.run_from, resource.max, resource.current);
+        }
+        in_run_ ^= bit;
+        return resource.max;
+    }
+
+    // After the change, outside a transaction max is rebuilt and current follows right away
+    void changed(std::size_t stat, NumberType old_max, bool proportional) 
+    {
+        const uint64_t bit = uint64_t{1} << stat;
+        if (depth_ > 0) {
+            dirty_ |= bit;
+            return;
+        }
+        recalculate(bit);
+        Resource& resource = resources_[stat];
+        if (proportional) {
+            rescaleCurrent(resource, old_max);
+        }
+        resource.current = std::min(resource.current, resource.max);
+    }
+
+    // Rebuilds whichever of stats have a max the transaction put off
+    void settle(uint64_t stats) 
+    {
+        stats &= dirty_;
+        if (stats != 0) {
+            recalculate(stats);
+            dirty_ &= ~stats;
+        }
+    }
+
+    // Points are about to change directly inside a transaction, so the scaling so far lands first
+    void flushScale(std::size_t stat) 
+    {
+        if (depth_ == 0) {
+            return;
+        }
+        const uint64_t bit = uint64_t{1} << stat;
+        settle(bit);
+        Resource& resource = resources_[stat];
+        if (in_run_ & bit) {
+            resource.scale.accumulate(resource.run_from, resource.max, resource.current);
+            resource.run_from = resource.max;
+        }
+        resource.scale.apply(resource.current);
+    }
+
+    // Same rounding as PointStat::rescaleCurrent
+    static void rescaleCurrent(Resource& resource, NumberType old_max) 
+    {
+        if (old_max == resource.max or resource.current == 0) {
+            return;
+        }
+        const NumberType scaled = resource.current < old_max 
+            ? StatMath::rescale(resource.current, resource.max, old_max) : resource.max;
+        resource.current = scaled > 0 ? scaled : NumberType{1};
+    }
+
+    // One pass over the modifiers rebuilds max for every dirty resource at once
+    void recalculate(uint64_t dirty) 
+    {
+        // Totals only for the dirty resources, packed by their rank in the dirty set
+        std::array<AggregateTotals<NumberType>, Count == DynamicStats ? 64 : Count> totals;
+        for (const auto& entry : entries_) {
+            const uint64_t bit = uint64_t{1} << entry.stat;
+            if (not (dirty & bit)) {
+                continue;
+            }
+            AggregateTotals<NumberType>& total = totals[std::popcount(dirty & (bit - 1))];
+            for (uint8_t stack = 0; stack < entry.stacks; ++stack) {
+                total.apply(modifierOf(entry), true);
+            }
+        }
+
+        std::size_t rank = 0;
+        for (uint64_t bits = dirty; bits != 0; bits &= bits - 1) {
+            Resource& resource = resources_[std::countr_zero(bits)];
+            resource.max = totals[rank++].evaluate(resource.base_max);
+        }
+    }
+
+    Resources resources_{};
+    SmallVector<Entry, InlineModifiers> entries_;
+    ModifierSlots<InlineModifiers> slots_;
+    ModifierSourceIndex sources_;
+    LocalModifiers<NumberType> locals_;
+    uint32_t depth_ = 0;
+    uint64_t dirty_ = 0;    // resources whose max a transaction hasn't rebuilt yet
+    uint64_t in_run_ = 0;   // resources whose last change in the transaction was proportional
+};
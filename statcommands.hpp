@@ -0,0 +1,344 @@
+// MIT License
+
+// Author : Codinablack@github.com
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <tuple>
+#include <vector>
+#include "pointbasedstat.hpp"
+
+enum class StatCommandType : uint8_t {
+    Damage,
+    Heal,
+    AddModifier,
+    RemoveModifier
+};
+
+// Something a worker thread wants done to a stat.
+// source and sequence are set by whoever issues it (a caster id and its own running count
+// works well), they're what makes the resolve order the same no matter which thread won the push.
+template<PositiveNumber NumberType>
+struct StatCommand 
+{
+    uint64_t target = 0;
+    uint32_t source = 0;
+    uint32_t sequence = 0;
+    StatCommandType type = StatCommandType::Damage;
+    NumberType amount = 0;
+    Modifier<NumberType> modifier{Modifier<NumberType>::Type::Add, 0, false};
+    ModifierHandle handle;
+};
+
+// What a command actually did, in the order it was applied, for combat logs
+template<PositiveNumber NumberType>
+struct StatResult 
+{
+    uint64_t target = 0;
+    uint32_t source = 0;
+    uint32_t sequence = 0;
+    StatCommandType type = StatCommandType::Damage;
+    bool found = false;         // false if the target was gone by the time we got to it
+    NumberType applied = 0;     // points actually removed or added
+    NumberType excess = 0;      // overkill for damage, overheal for heals
+    ModifierHandle handle;      // what the stat handed back for AddModifier
+};
+
+// Bounded lock free queue, any number of threads push and exactly one pops.
+// Each cell carries a sequence number so producers only fight over the tail index,
+// never over the cells themselves (the usual Vyukov ring).
+template<class T>
+class MpscQueue {
+public:
+
+    // capacity is rounded up to a power of two
+    explicit MpscQueue(std::size_t capacity) 
+    {
+        std::size_t size = 2;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        mask_ = size - 1;
+        cells_ = std::make_unique<Cell[]>(size);
+        for (std::size_t i = 0; i < size; ++i) {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    // Returns false if the queue is full, nothing is pushed then
+    bool push(const T& value) 
+    {
+        std::size_t position = tail_.load(std::memory_order_relaxed);
+        Cell* cell;
+        for (;;) {
+            cell = &cells_[position & mask_];
+            const std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            const auto difference = static_cast<std::ptrdiff_t>(sequence - position);
+            if (difference == 0) {
+                if (tail_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            }
+            else if (difference < 0) {
+                return false;
+            }
+            else {
+                position = tail_.load(std::memory_order_relaxed);
+            }
+        }
+        cell->value = value;
+        cell->sequence.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side only
+    bool pop(T& out) 
+    {
+        Cell& cell = cells_[head_ & mask_];
+        if (cell.sequence.load(std::memory_order_acquire) != head_ + 1) {
+            return false;
+        }
+        out = cell.value;
+        cell.sequence.store(head_ + mask_ + 1, std::memory_order_release);
+        ++head_;
+        return true;
+    }
+
+    std::size_t capacity() const 
+    {
+        return mask_ + 1;
+    }
+
+private:
+
+    struct Cell 
+    {
+        std::atomic<std::size_t> sequence;
+        T value;
+    };
+
+    std::unique_ptr<Cell[]> cells_;
+    std::size_t mask_ = 0;
+    // Kept on separate cache lines so producers don't keep stealing the consumer's line
+    alignas(64) std::atomic<std::size_t> tail_{0};
+    alignas(64) std::size_t head_ = 0;
+};
+
+// Lets combat run on many threads while every PointStat is still only touched by one.
+// Workers push commands, which land in the shard that owns the target. At tick end each shard
+// is resolved by a single thread (different shards can run on different threads), applying
+// its commands sorted by target, source and sequence so the outcome is deterministic.
+template<PositiveNumber NumberType, class Policy = OverflowPolicy::Clamp>
+class StatCommandPipeline {
+public:
+
+    StatCommandPipeline(std::size_t shards, std::size_t capacity_per_shard) 
+    {
+        if (shards == 0) 
+        {
+            throw std::invalid_argument("StatCommandPipeline needs at least one shard");
+        }
+        shards_.reserve(shards);
+        for (std::size_t i = 0; i < shards; ++i) {
+            shards_.push_back(std::make_unique<Shard>(capacity_per_shard));
+        }
+    }
+
+    // Thread safe, returns false if the target's shard is full
+    bool push(const StatCommand<NumberType>& command) 
+    {
+        return shards_[shardOf(command.target)]->queue.push(command);
+    }
+
+    bool damage(uint64_t target, uint32_t source, uint32_t sequence, NumberType amount) 
+    {
+        auto command = makeCommand(target, source, sequence, StatCommandType::Damage);
+        command.amount = amount;
+        return push(command);
+    }
+
+    bool heal(uint64_t target, uint32_t source, uint32_t sequence, NumberType amount) 
+    {
+        auto command = makeCommand(target, source, sequence, StatCommandType::Heal);
+        command.amount = amount;
+        return push(command);
+    }
+
+    bool addModifier(uint64_t target, uint32_t source, uint32_t sequence, const Modifier<NumberType>& modifier) 
+    {
+        auto command = makeCommand(target, source, sequence, StatCommandType::AddModifier);
+        command.modifier = modifier;
+        return push(command);
+    }
+
+    bool removeModifier(uint64_t target, uint32_t source, uint32_t sequence, ModifierHandle handle) 
+    {
+        auto command = makeCommand(target, source, sequence, StatCommandType::RemoveModifier);
+        command.handle = handle;
+        return push(command);
+    }
+
+    std::size_t shardOf(uint64_t target) const 
+    {
+        // Entity ids tend to be sequential, mix them so shards stay even
+        target ^= target >> 33;
+        target *= 0xff51afd7ed558ccdull;
+        target ^= target >> 33;
+        return static_cast<std::size_t>(target % shards_.size());
+    }
+
+    std::size_t shards() const 
+    {
+        return shards_.size();
+    }
+
+    // Drains one shard and applies everything in it. Only one thread may resolve a given shard at a time.
+    // lookup maps a target id to its PointStat<NumberType, Policy>*, or nullptr if it's gone.
+    // Results are appended in the order the commands were applied, returns how many.
+    template<class Lookup>
+    std::size_t resolve(std::size_t shard, Lookup&& lookup, std::vector<StatResult<NumberType>>& results) 
+    {
+        Shard& state = *shards_[shard];
+        auto& pending = state.pending;
+        pending.clear();
+        StatCommand<NumberType> command;
+        while (state.queue.pop(command)) {
+            pending.push_back(command);
+        }
+
+        std::stable_sort(pending.begin(), pending.end(), [](const auto& a, const auto& b) {
+            return orderKey(a) < orderKey(b);
+        });
+
+        results.reserve(results.size() + pending.size());
+        PointStat<NumberType, Policy>* stat = nullptr;
+        for (std::size_t i = 0; i < pending.size(); ++i) {
+            const auto& next = pending[i];
+            // Commands for one target sit together after the sort, so look it up once
+            if (i == 0 or pending[i - 1].target != next.target) {
+                stat = lookup(next.target);
+            }
+            results.push_back(apply(stat, next));
+        }
+        return pending.size();
+    }
+
+    template<class Lookup>
+    std::size_t resolveAll(Lookup&& lookup, std::vector<StatResult<NumberType>>& results) 
+    {
+        std::size_t total = 0;
+        for (std::size_t shard = 0; shard < shards_.size(); ++shard) {
+            total += resolve(shard, lookup, results);
+        }
+        return total;
+    }
+
+private:
+
+    struct Shard 
+    {
+        explicit Shard(std::size_t capacity) 
+            : queue(capacity)
+        {
+        }
+
+        MpscQueue<StatCommand<NumberType>> queue;
+        std::vector<StatCommand<NumberType>> pending;
+    };
+
+    // target, source and sequence decide the order. Issuers aren't made to keep sequence unique,
+    // so two commands that tie on those go by what they contain, and only identical commands
+    // (which do the same thing either way round) are left in whatever order they were popped.
+    static auto orderKey(const StatCommand<NumberType>& command) 
+    {
+        const auto& modifier = command.modifier;
+        return std::make_tuple(command.target, command.source, command.sequence, command.type, command.amount,
+                               modifier.getType(), modifier.getValue(), modifier.getProportionalScaling(),
+                               modifier.getSource(), modifier.getStackPolicy(), modifier.getMaxStacks(),
+                               command.handle.index, command.handle.generation);
+    }
+
+    static StatCommand<NumberType> makeCommand(uint64_t target, uint32_t source, uint32_t sequence, StatCommandType type) 
+    {
+        StatCommand<NumberType> command;
+        command.target = target;
+        command.source = source;
+        command.sequence = sequence;
+        command.type = type;
+        return command;
+    }
+
+    static StatResult<NumberType> apply(PointStat<NumberType, Policy>* stat, const StatCommand<NumberType>& command) 
+    {
+        StatResult<NumberType> result;
+        result.target = command.target;
+        result.source = command.source;
+        result.sequence = command.sequence;
+        result.type = command.type;
+        if (stat == nullptr) {
+            return result;
+        }
+        result.found = true;
+
+        switch (command.type)
+        {
+            case StatCommandType::Damage:
+            {
+                const NumberType current = stat->current();
+                result.applied = std::min(command.amount, current);
+                result.excess = command.amount - result.applied;
+                stat->remove(command.amount);
+                break;
+            }
+
+            case StatCommandType::Heal:
+            {
+                const NumberType room = stat->max() - stat->current();
+                result.applied = std::min(command.amount, room);
+                result.excess = command.amount - result.applied;
+                stat->add(command.amount);
+                break;
+            }
+
+            case StatCommandType::AddModifier:
+            {
+                result.handle = stat->addModifier(command.modifier);
+                break;
+            }
+
+            case StatCommandType::RemoveModifier:
+            {
+                result.handle = command.handle;
+                stat->removeModifier(command.handle);
+                break;
+            }
+        }
+        return result;
+    }
+
+    // Shards are boxed so their queues never share a cache line with a neighbour's
+    std::vector<std::unique_ptr<Shard>> shards_;
+};
@@ -0,0 +1,329 @@
+// MIT License
+
+// Author : Codinablack@github.com
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include "customskill.hpp"
+#include "pointbasedstat.hpp"
+
+// Keeps derived stats in sync with what they're derived from, e.g. max health from the
+// Constitution level, or max mana from Magic and max health together.
+// Skills and stats are nodes, rules are functions of some nodes that either set a stat's
+// base max or own one modifier on it. update() runs once per tick, picks up skill level
+// changes and re-evaluates only the rules downstream of something that actually changed,
+// in dependency order, so every rule runs at most once per update.
+// The graph keeps references to the skills and stats, they must outlive it.
+template<PositiveNumber NumberType, class Policy = OverflowPolicy::Clamp>
+class StatGraph {
+public:
+
+    using NodeId = uint32_t;
+    // Gets the current value of each input in the order they were linked,
+    // a skill's level or a stat's max
+    using Formula = std::function<NumberType(std::span<const uint64_t>)>;
+
+    NodeId addSkill(const Components::Skills::CustomSkill& skill, bool count_bonus = true) 
+    {
+        Node node;
+        node.kind = Kind::Skill;
+        node.skill = &skill;
+        node.count_bonus = count_bonus;
+        node.value = skill.level(count_bonus);
+        return addNode(std::move(node));
+    }
+
+    NodeId addStat(PointStat<NumberType, Policy>& stat) 
+    {
+        Node node;
+        node.kind = Kind::Stat;
+        node.stat = &stat;
+        node.value = stat.max();
+        return addNode(std::move(node));
+    }
+
+    // stat's base max becomes formula(inputs), a stat can only have one of these
+    NodeId deriveBase(NodeId stat, std::span<const NodeId> inputs, Formula formula, bool proportional = true) 
+    {
+        if (nodes_.at(stat).has_base) 
+        {
+            throw std::invalid_argument("StatGraph stat already has a derived base");
+        }
+        NodeId rule = link(stat, inputs, std::move(formula), Kind::BaseRule, proportional);
+        nodes_[stat].has_base = true;
+        return rule;
+    }
+
+    // Keeps one modifier of the given type on stat with formula(inputs) as its value
+    NodeId deriveModifier(NodeId stat, std::span<const NodeId> inputs, typename Modifier<NumberType>::Type type, Formula formula, bool proportional = true) 
+    {
+        NodeId rule = link(stat, inputs, std::move(formula), Kind::ModifierRule, proportional);
+        nodes_[rule].type = type;
+        return rule;
+    }
+
+    // For stats whose max was changed behind the graph's back (a buff, an item),
+    // their dependents get re-evaluated on the next update
+    void markDirty(NodeId node) 
+    {
+        enqueue(node);
+    }
+
+    // Returns how many rules were evaluated
+    std::size_t update() 
+    {
+        for (NodeId id : skills_) {
+            Node& node = nodes_[id];
+            uint64_t level = node.skill->level(node.count_bonus);
+            if (level != node.value) {
+                node.value = level;
+                enqueueDependents(node);
+            }
+        }
+
+        std::size_t evaluated = 0;
+        while (not queue_.empty()) {
+            std::pop_heap(queue_.begin(), queue_.end(), std::greater<>{});
+            NodeId id = queue_.back().second;
+            queue_.pop_back();
+            Node& node = nodes_[id];
+            node.queued = false;
+
+            switch (node.kind)
+            {
+                case Kind::Skill:
+                {
+                    node.value = node.skill->level(node.count_bonus);
+                    enqueueDependents(node);
+                    break;
+                }
+
+                case Kind::Stat:
+                {
+                    uint64_t max = node.stat->max();
+                    if (max != node.value) {
+                        node.value = max;
+                        enqueueDependents(node);
+                    }
+                    break;
+                }
+
+                case Kind::BaseRule:
+                case Kind::ModifierRule:
+                {
+                    ++evaluated;
+                    evaluate(id);
+                    break;
+                }
+            }
+        }
+        return evaluated;
+    }
+
+private:
+
+    enum class Kind : uint8_t {
+        Skill,
+        Stat,
+        BaseRule,
+        ModifierRule
+    };
+
+    struct Node 
+    {
+        Kind kind = Kind::Stat;
+        bool queued = false;
+        bool has_base = false;          // stats, a base rule already targets it
+        bool count_bonus = true;        // skills
+        bool proportional = true;       // rules
+        bool evaluated = false;         // rules, value holds the last result once set
+        typename Modifier<NumberType>::Type type = Modifier<NumberType>::Type::Add;
+        uint32_t rank = 0;              // longest path from a skill, evaluation order
+        uint64_t value = 0;
+        const Components::Skills::CustomSkill* skill = nullptr;
+        PointStat<NumberType, Policy>* stat = nullptr;
+        NodeId target = 0;
+        ModifierHandle handle;
+        Formula formula;
+        std::vector<NodeId> inputs;
+        std::vector<NodeId> dependents;
+    };
+
+    NodeId addNode(Node&& node) 
+    {
+        NodeId id = static_cast<NodeId>(nodes_.size());
+        if (node.kind == Kind::Skill) {
+            skills_.push_back(id);
+        }
+        nodes_.push_back(std::move(node));
+        return id;
+    }
+
+    NodeId link(NodeId stat, std::span<const NodeId> inputs, Formula formula, Kind kind, bool proportional) 
+    {
+        if (nodes_.at(stat).kind != Kind::Stat) 
+        {
+            throw std::invalid_argument("StatGraph rules can only target stats");
+        }
+        for (NodeId input : inputs) {
+            if (nodes_.at(input).kind == Kind::BaseRule or nodes_[input].kind == Kind::ModifierRule) 
+            {
+                throw std::invalid_argument("StatGraph rule inputs must be skills or stats");
+            }
+        }
+        // The new edges run inputs -> rule -> stat, so anything downstream of stat
+        // feeding the rule would close a loop
+        if (reaches(stat, inputs)) 
+        {
+            throw std::invalid_argument("StatGraph link would create a cycle");
+        }
+
+        Node node;
+        node.kind = kind;
+        node.target = stat;
+        node.formula = std::move(formula);
+        node.proportional = proportional;
+        node.inputs.assign(inputs.begin(), inputs.end());
+        NodeId rule = addNode(std::move(node));
+        for (NodeId input : inputs) {
+            nodes_[input].dependents.push_back(rule);
+        }
+        nodes_[rule].dependents.push_back(stat);
+        rerank();
+        enqueue(rule);
+        return rule;
+    }
+
+    bool reaches(NodeId from, std::span<const NodeId> targets) 
+    {
+        std::vector<uint8_t> seen(nodes_.size(), 0);
+        std::vector<NodeId> stack{from};
+        while (not stack.empty()) {
+            NodeId id = stack.back();
+            stack.pop_back();
+            if (std::find(targets.begin(), targets.end(), id) != targets.end()) {
+                return true;
+            }
+            if (seen[id]) {
+                continue;
+            }
+            seen[id] = 1;
+            for (NodeId next : nodes_[id].dependents) {
+                stack.push_back(next);
+            }
+        }
+        return false;
+    }
+
+    // Links only happen at setup, so just redo every rank in topological order
+    void rerank() 
+    {
+        std::vector<uint32_t> pending(nodes_.size(), 0);
+        for (const auto& node : nodes_) {
+            for (NodeId next : node.dependents) {
+                ++pending[next];
+            }
+        }
+        std::vector<NodeId> ready;
+        for (NodeId id = 0; id < nodes_.size(); ++id) {
+            nodes_[id].rank = 0;
+            if (pending[id] == 0) {
+                ready.push_back(id);
+            }
+        }
+        while (not ready.empty()) {
+            NodeId id = ready.back();
+            ready.pop_back();
+            for (NodeId next : nodes_[id].dependents) {
+                nodes_[next].rank = std::max(nodes_[next].rank, nodes_[id].rank + 1);
+                if (--pending[next] == 0) {
+                    ready.push_back(next);
+                }
+            }
+        }
+        // Anything queued was pushed with its old rank
+        for (auto& entry : queue_) {
+            entry.first = nodes_[entry.second].rank;
+        }
+        std::make_heap(queue_.begin(), queue_.end(), std::greater<>{});
+    }
+
+    void enqueue(NodeId id) 
+    {
+        Node& node = nodes_.at(id);
+        if (node.queued) {
+            return;
+        }
+        node.queued = true;
+        queue_.emplace_back(node.rank, id);
+        std::push_heap(queue_.begin(), queue_.end(), std::greater<>{});
+    }
+
+    void enqueueDependents(const Node& node) 
+    {
+        for (NodeId next : node.dependents) {
+            enqueue(next);
+        }
+    }
+
+    void evaluate(NodeId id) 
+    {
+        Node& rule = nodes_[id];
+        values_.clear();
+        for (NodeId input : rule.inputs) {
+            values_.push_back(nodes_[input].value);
+        }
+        NumberType result = rule.formula(values_);
+        if (rule.evaluated and result == rule.value) {
+            return;
+        }
+
+        PointStat<NumberType, Policy>& stat = *nodes_[rule.target].stat;
+        if (rule.kind == Kind::BaseRule) {
+            stat.setBaseMax(result, rule.proportional);
+        }
+        else if (stat.hasModifier(rule.handle)) {
+            // Changed where it sits, so a sequential stat applies it in the same place as before
+            stat.updateModifier(rule.handle, result);
+        }
+        else {
+            rule.handle = stat.addModifier(Modifier<NumberType>(rule.type, result, rule.proportional));
+            // The stat turned it down, so nothing is cached and the next evaluation tries again
+            if (not rule.handle) {
+                return;
+            }
+        }
+        rule.evaluated = true;
+        rule.value = result;
+        enqueue(rule.target);
+    }
+
+    std::vector<Node> nodes_;
+    std::vector<NodeId> skills_;
+    std::vector<std::pair<uint32_t, NodeId>> queue_;
+    std::vector<uint64_t> values_;
+};